@@ -50,7 +50,7 @@ function run_gpue {
 	fi
 	echo "$NAME$A"
 	mkdir -p $NAME$A
-	cp ./gpue ./$NAME$A; cp -r ./src ./$NAME$A; cp -r ./include ./$NAME$A; cp ./Makefile ./$NAME$A; cp -r ./py ./$NAME$A; cp -r ./bin ./$NAME$A; cp ./wfc_load ./$NAME$A; cp ./wfci_load ./$NAME$A;
+	cp ./gpue ./$NAME$A; cp -r ./src ./$NAME$A; cp -r ./include ./$NAME$A; cp ./Makefile ./$NAME$A; cp -r ./py ./$NAME$A; cp -r ./bin ./$NAME$A; cp ./wfc_load ./$NAME$A; cp ./wfci_load ./$NAME$A; cp ./wfc_load.bin ./$NAME$A 2>/dev/null;
 	cd ./$NAME$A
 	pwd >> result.log
 	echo $1 >>result.log
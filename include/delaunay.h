@@ -0,0 +1,160 @@
+///@cond LICENSE
+/*** delaunay.h - GPUE: Split Operator based GPU solver for Nonlinear
+Schrodinger Equation, Copyright (C) 2011-2015, Lee J. O'Riordan
+<loriordan@gmail.com>, Tadhg Morgan, Neil Crowley.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+///@endcond
+//##############################################################################
+/**
+ *  @file    delaunay.h
+ *  @author  Lee J. O'Riordan (mlxd)
+ *  @date    18/10/2026
+ *  @version 0.1
+ *
+ *  @brief Delaunay triangulation of vortex positions
+ *
+ *  @section DESCRIPTION
+ *  Incremental (Bowyer-Watson) triangulation of the refined vortex cores.
+ *  Points are inserted in Hilbert order and located by walking from the
+ *  last triangle made, so a frame costs close to O(n). The triangulation
+ *  is kept between frames and updated by vortex UID: vortices whose moves
+ *  keep it Delaunay only have their positions changed, and only births,
+ *  deaths and the remaining moves are re-triangulated locally.
+ */
+ //##############################################################################
+
+#ifndef LATTICEGRAPH_DELAUNAY_H
+#define LATTICEGRAPH_DELAUNAY_H
+
+#include <vector>
+#include <unordered_map>
+#include "tracker.h"
+
+namespace LatticeGraph {
+
+    class Delaunay {
+
+    private:
+	    struct Tri {
+		    int v[3]; //Vertex slots, counter-clockwise
+		    int n[3]; //Neighbour across the edge opposite v[k], -1 for none
+	    };
+	    /*
+	     * Vertices live in slots that persist while their vortex does, keyed
+	     * by vortex UID. Slots 0-2 hold the super-triangle, whose vertices
+	     * are symbolic points at infinity.
+	     */
+	    std::vector<double> px, py; //Jittered positions by slot
+	    std::vector<int> vtri; //A triangle holding each slot, -1 if not triangulated
+	    std::vector<int> slotIdx; //Input index of each slot this frame, -1 if unseen
+	    std::vector<unsigned int> slotUid;
+	    std::vector<char> slotLive;
+	    std::vector<int> freeSlots, inSlot;
+	    std::unordered_map<unsigned int, int> slotOfUid;
+	    bool keyed; //Every slot has a unique UID, so update() may be used
+
+	    std::vector<Tri> tris;
+	    std::vector<int> freeTris, cavity, mark, fanA, fanB, order;
+	    std::vector<int> bndA, bndB, bndN; //Cavity boundary edges and the triangles beyond them
+	    std::vector<int> poly, polyN; //Hole left by a removed vertex and the triangles beyond it
+	    std::vector<unsigned int> edgeA, edgeB;
+	    std::vector<char> hull;
+	    std::vector<double> hullX, hullY; //Convex hull, counter-clockwise
+	    int stamp, last;
+	    unsigned int retri; //Vortices re-triangulated by the last call
+
+	    double orient(int a, int b, int p);
+	    bool inCircle(int a, int b, int c, int p);
+	    bool inCircle(const Tri &t, int p);
+	    int newTri(int a, int b, int c);
+	    void link(int x, int a, int b, int t);
+	    int locate(int p);
+	    bool insert(int p);
+	    bool remove(int p);
+	    bool starValid(int p);
+	    bool inHull(double x, double y);
+	    bool move(int p, double x, double y);
+	    int newSlot(const Vtx::Vortex &v, int idx);
+	    unsigned int extract(unsigned int num);
+
+    public:
+	    Delaunay();
+
+		/**
+		* @brief	Triangulates the refined positions of num vortices
+		* @ingroup	graph
+		* @param	*v Vortices
+		* @param	num Number of vortices
+		* @return	Number of Delaunay edges
+		*/
+	    unsigned int triangulate(const Vtx::Vortex *v, unsigned int num);
+		/**
+		* @brief	Updates the triangulation from the previous call, matching vortices by UID. Vanished vortices are removed, new ones inserted, and moved ones re-triangulated only where the move broke the Delaunay property. Falls back to triangulate() when that is not possible.
+		* @ingroup	graph
+		* @param	*v Vortices
+		* @param	num Number of vortices
+		* @return	Number of Delaunay edges
+		*/
+	    unsigned int update(const Vtx::Vortex *v, unsigned int num);
+		/**
+		* @brief	Returns the number of vortices removed and re-inserted by the last update(), or all of them after a full triangulation
+		* @ingroup	graph
+		* @return	Number of re-triangulated vortices
+		*/
+	    unsigned int getNumRetriangulated();
+		/**
+		* @brief	Returns the first vortex index of each edge
+		* @ingroup	graph
+		* @return	Vector of edge ends
+		*/
+	    const std::vector<unsigned int> &getEdgeA();
+		/**
+		* @brief	Returns the second vortex index of each edge
+		* @ingroup	graph
+		* @return	Vector of edge ends
+		*/
+	    const std::vector<unsigned int> &getEdgeB();
+		/**
+		* @brief	Returns whether each vortex lies on the convex hull, or coincides with another vortex. Their coordination is not meaningful.
+		* @ingroup	graph
+		* @return	Vector of flags, by vortex index
+		*/
+	    const std::vector<char> &getHull();
+		/**
+		* @brief	Voronoi cell of each vortex from the last triangulation, built from the circumcentres around it. Cells on or next to the hull, or reaching outside it, are open and get 0 for both.
+		* @ingroup	graph
+		* @param	*area Cell areas, by vortex index
+		* @param	*sides Number of cell sides, by vortex index
+		*/
+	    void voronoi(double *area, unsigned int *sides);
+    };
+}
+#endif //LATTICEGRAPH_DELAUNAY_H
@@ -0,0 +1,162 @@
+///@cond LICENSE
+/*** events.h - GPUE: Split Operator based GPU solver for Nonlinear
+Schrodinger Equation, Copyright (C) 2011-2015, Lee J. O'Riordan
+<loriordan@gmail.com>, Tadhg Morgan, Neil Crowley.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+///@endcond
+//##############################################################################
+/**
+ *  @file    events.h
+ *  @author  Lee J. O'Riordan (mlxd)
+ *  @date    18/10/2026
+ *  @version 0.1
+ *
+ *  @brief Vortex event detection for event-driven output.
+ *
+ *  @section DESCRIPTION
+ *  Compares consecutive linked vortex samples for births, deaths,
+ *  annihilating and nucleating pairs, count changes and large jumps. Each
+ *  event is logged, and opens a window of high-rate sampling and full
+ *  snapshots. The steps of the last few quiet samples are kept in a ring,
+ *  so the caller can write out the states it held before the trigger.
+ */
+ //##############################################################################
+
+#ifndef EVENTS_H
+#define EVENTS_H
+#include <cstdio>
+#include <vector>
+#include "vort.h"
+
+namespace Events {
+
+	/**
+	* Event types, combined as a bitmask by Engine::observe.
+	*/
+	enum EventType {
+		EV_BIRTH = 1,
+		EV_DEATH = 2,
+		EV_ANNIHILATION = 4, //Opposite windings dying together
+		EV_CREATION = 8, //Opposite windings born together
+		EV_COUNT = 16, //Net change in the number of vortices
+		EV_JUMP = 32 //Displacement above the jump threshold
+	};
+
+	class Engine {
+		private:
+			FILE *log;
+			int window; //Samples held before a trigger and taken after it
+			int steps; //Sampling cadence inside a window
+			double jump, pairDist;
+			bool primed;
+			int windowEnd;
+			std::vector<int> ringStep;
+			int ringHead, ringCount;
+
+			void logEvent(int step, const char *type, long uid, double x, double y, double data);
+
+		public:
+			Engine();
+			~Engine();
+
+			/**
+			* @brief	Opens the event log and sets the trigger parameters
+			* @ingroup	data
+			* @param	*file Name of the event log
+			* @param	window Number of samples held before a trigger, and written after it
+			* @param	steps Steps between samples inside a window
+			* @param	jump Displacement in grid cells between samples that counts as an event
+			* @param	pairDist Largest separation in grid cells of an annihilating or nucleating pair
+			* @param	fromStep Step the run resumed from, -1 for a fresh run. Events already logged from this step on are dropped
+			* @return	0 on success, -1 if the log could not be opened
+			*/
+			int open(char *file, int window, int steps, double jump, double pairDist, int fromStep);
+
+			/**
+			* @brief	Checks the engine is running
+			* @ingroup	data
+			* @return	true if open
+			*/
+			bool isOpen();
+
+			/**
+			* @brief	Compares two linked samples, logs the events found and opens a window if there were any. The first sample after opening only primes the engine.
+			* @ingroup	data
+			* @param	*prev Previous sample
+			* @param	numPrev Number of vortices in prev
+			* @param	*cur Current sample, linked to prev
+			* @param	num Number of vortices in cur
+			* @param	step Step of the current sample
+			* @return	Bitmask of EventType, 0 if nothing happened
+			*/
+			int observe(const Vtx::Vortex *prev, int numPrev, const Vtx::Vortex *cur, int num, int step);
+
+			/**
+			* @brief	Checks whether a step lies inside an open window
+			* @ingroup	data
+			* @param	step Simulation step
+			* @return	true if inside a window
+			*/
+			bool inWindow(int step);
+
+			/**
+			* @brief	Checks whether a window wants a sample at this step
+			* @ingroup	data
+			* @param	step Simulation step
+			* @return	true if a sample is due
+			*/
+			bool sampleDue(int step);
+
+			/**
+			* @brief	Reserves the ring slot for the state at a quiet sample, evicting the oldest once the ring is full
+			* @ingroup	data
+			* @param	step Step of the sample
+			* @return	Slot index, 0 to window-1
+			*/
+			int push(int step);
+
+			/**
+			* @brief	Empties the ring, oldest first
+			* @ingroup	data
+			* @param	*slot Output slot indices, at least window long
+			* @param	*step Output steps of the held states
+			* @return	Number of held states
+			*/
+			int drain(int *slot, int *step);
+
+			/**
+			* @brief	Closes the event log
+			* @ingroup	data
+			*/
+			void close();
+	};
+}
+#endif
@@ -69,6 +69,90 @@ namespace FileIO {
     */
     double2 *readIn(char* fileR, char* fileI, int xDim, int yDim);
 
+	/**
+	* Header preceding the raw data of binary snapshot files. Data follows
+	* immediately after, as count elements of elemSize bytes each, in host
+	* byte order.
+	*/
+	struct SnapHeader {
+		char magic[4]; //"GPUE"
+		unsigned int version;
+		int xDim;
+		int yDim;
+		int step;
+		unsigned int elemSize;
+		unsigned long long count;
+	};
+
+	/**
+    * @brief	Memory-maps a binary snapshot and copies it into an existing buffer
+    * @ingroup	helper
+    *
+    * @param	*file Name of binary snapshot file
+    * @param	*dest Buffer of xDim*yDim elements to receive the data
+    * @param	xDim Size of x-grid. Must match the snapshot header
+    * @param	yDim Size of y-grid. Must match the snapshot header
+    * @return	*double2 dest on success, NULL if the file is missing or the header does not match the grid
+    */
+    double2 *readInBin(char* file, double2 *dest, int xDim, int yDim);
+
+	/**
+	* Solver state captured at the start of a step, sufficient to continue an
+	* evolution from that step as if it had never stopped.
+	*/
+	struct Checkpoint {
+		int gstate; //0 groundstate, 1 real-time evolution
+		int step; //Next step to be evolved
+		double omega_0; //Current rotation rate, including ramp position
+		int num_kick; //Optical lattice kicks applied so far
+		int num_vortices[2]; //Current and previous vortex counts
+		int vortCap; //Allocated length of the vortex arrays
+		int hasOpt; //1 if EV_opt has been set up and is stored
+		double vort_angle;
+		double sepAvg;
+		struct Vtx::Vortex central_vortex;
+		unsigned int nextUid; //Next vortex UID to hand out
+		int trackCount; //Tracking samples so far, which sets when the next full scan falls
+		int skSamples; //Samples in the stored S(k) moments, 0 if none
+		int skStep; //Step of the last S(k) sample
+	};
+
+	/**
+    * @brief	Writes a full solver checkpoint. The file is replaced atomically.
+    * @ingroup	helper
+    *
+    * @param	*file Name of checkpoint file
+	* @param	&chk Scalar solver state
+	* @param	*wfc Host copy of the wavefunction
+    * @param	xDim Size of x-grid
+    * @param	yDim Size of y-grid
+	* @param	*vortCoordsP Previous vortex coordinates, chk.vortCap long. May be NULL if vortCap is 0
+	* @param	*EV_opt Optical lattice operator. Only written if chk.hasOpt
+	* @param	&arr Accumulated parameter Array
+	* @param	&vortices Vortex identities and lifetimes
+	* @param	*skMoments Running mean then M2 of S(k), 2*xDim*(yDim/2+1) long. Only written if chk.skSamples > 0
+	* @return	0 on success, -1 if the file could not be written
+    */
+    int writeCheckpoint(char *file, Checkpoint &chk, double2 *wfc, int xDim, int yDim, struct Vtx::Vortex *vortCoordsP, double2 *EV_opt, Array &arr, Vtx::VtxList &vortices, double *skMoments);
+
+	/**
+    * @brief	Reads a full solver checkpoint written by writeCheckpoint
+    * @ingroup	helper
+    *
+    * @param	*file Name of checkpoint file
+	* @param	&chk Receives the scalar solver state
+	* @param	*wfc Buffer of xDim*yDim elements to receive the wavefunction
+    * @param	xDim Size of x-grid. Must match the checkpoint
+    * @param	yDim Size of y-grid. Must match the checkpoint
+	* @param	**vortCoordsP Receives a malloc'd array of chk.vortCap previous vortices, or NULL
+	* @param	*EV_opt Receives the optical lattice operator if chk.hasOpt
+	* @param	*arr Parameter Array, replaced by the checkpointed one
+	* @param	*vortices Vortex list, replaced by the checkpointed one
+	* @param	**skMoments Receives a malloc'd array of the S(k) mean then M2 if chk.skSamples > 0, or NULL
+	* @return	0 on success, -1 otherwise
+    */
+    int readCheckpoint(char *file, Checkpoint &chk, double2 *wfc, int xDim, int yDim, struct Vtx::Vortex **vortCoordsP, double2 *EV_opt, Array *arr, Vtx::VtxList *vortices, double **skMoments);
+
     /**
     * @brief	Writes the specified double2 array to a text file
     * @ingroup	helper
@@ -81,6 +165,19 @@ namespace FileIO {
     */
     void writeOut(char* buffer, char *file, double2 *data, int length, int step);
 
+	/**
+    * @brief	Writes the specified double2 array to a binary snapshot file
+    * @ingroup	helper
+    *
+    * @param	*buffer Char buffer for use by function internals. char[100] usually
+    * @param	*file Name of data file name for saving to
+	* @param	*data double2 array to be written out
+    * @param	xDim Size of x-grid
+    * @param	yDim Size of y-grid
+    * @param	step Index for the filename. file_step.bin
+    */
+    void writeOutBin(char* buffer, char *file, double2 *data, int xDim, int yDim, int step);
+
 	/**
     * @brief	Writes the specified double array to a text file
     * @ingroup	helper
@@ -91,7 +188,7 @@ namespace FileIO {
     * @param	length Overall length of the file to write out
     * @param	step Index for the filename. file_step
     */
-    void writeOutDouble(char* buffer, char *file, double *data, int length, int step);
+    void writeOutDouble(char* buffer, const char *file, double *data, int length, int step);
 
 	/**
     * @brief	Writes the specified int array to a text file
@@ -129,6 +226,154 @@ namespace FileIO {
     */
     void writeOutVortex(char *buffer, char *file, struct Vtx::Vortex *data, int length, int step);
 
+	/**
+    * @brief	Writes the specified Vtx::Vortex array to a text file, with the vortex UID as a final column
+    * @ingroup	helper
+    *
+    * @param	*buffer Char buffer for use by function internals. char[100] usually
+    * @param	*file Name of data file name for saving to
+	* @param	*data Vtx::Vortex array to be written out
+    * @param	length Overall length of the file to write out
+    * @param	step Index for the filename. file_step
+    */
+    void writeOutVortexUid(char *buffer, char *file, struct Vtx::Vortex *data, int length, int step);
+
+	/**
+    * @brief	Writes the UID, winding, birth and death step of every vortex recorded in a VtxList
+    * @ingroup	helper
+    *
+    * @param	*buffer Char buffer for use by function internals. char[100] usually
+    * @param	*file Name of data file name for saving to
+	* @param	&vortices Vortex list. Live vortices have a death step of -1
+    */
+    void writeOutVortexLife(char *buffer, char *file, Vtx::VtxList &vortices);
+
+	/**
+    * @brief	Writes the UID, refined position, coordination number and hull flag of each vortex
+    * @ingroup	helper
+    *
+    * @param	*buffer Char buffer for use by function internals. char[100] usually
+    * @param	*file Name of data file name for saving to
+	* @param	*data Vtx::Vortex array to be written out
+	* @param	*coord Coordination number of each vortex
+	* @param	*hull Nonzero for vortices on the hull of the triangulation
+    * @param	length Number of vortices
+    * @param	step Index for the filename. file_step
+    */
+    void writeOutCoordination(char *buffer, char *file, struct Vtx::Vortex *data, unsigned int *coord, char *hull, int length, int step);
+
+	/**
+    * @brief	Writes the UID, refined position, psi6 and Voronoi cell of each vortex
+    * @ingroup	helper
+    *
+    * @param	*buffer Char buffer for use by function internals. char[100] usually
+    * @param	*file Name of data file name for saving to
+	* @param	*data Vtx::Vortex array to be written out
+	* @param	*psi psi6 of each vortex
+	* @param	*area Voronoi cell area of each vortex, 0 for open cells
+	* @param	*sides Voronoi cell sides of each vortex, 0 for open cells
+    * @param	length Number of vortices
+    * @param	step Index for the filename. file_step
+    */
+    void writeOutOrder(char *buffer, const char *file, struct Vtx::Vortex *data, double2 *psi, double *area, unsigned int *sides, int length, int step);
+
+	/**
+    * @brief	Writes a binned g6(r) with the number of pairs in each bin
+    * @ingroup	helper
+    *
+    * @param	*buffer Char buffer for use by function internals. char[100] usually
+    * @param	*file Name of data file name for saving to
+    * @param	rMax Range of the bins, in grid cells
+    * @param	bins Number of bins
+	* @param	*g6 Correlation in each bin
+	* @param	*pairs Pairs in each bin
+    * @param	step Index for the filename. file_step
+    */
+    void writeOutG6(char *buffer, const char *file, double rMax, int bins, double *g6, double *pairs, int step);
+
+	/**
+    * @brief	Reads a vortex file written by writeOutVortexUid
+    * @ingroup	helper
+    *
+    * @param	*file Name of the vortex file
+    * @param	*length Number of vortices read
+    * @return	Vortex array, to be freed by the caller. NULL if the file cannot be read
+    */
+    struct Vtx::Vortex *readVortexUid(char *file, int *length);
+
+	/**
+    * @brief	Opens a text series, one row per sample led by its step, for appending. The first open of a file in a process starts it afresh, or on a resumed run keeps only the rows before the resume step
+    * @ingroup	helper
+    *
+    * @param	*file Name of the series
+    * @param	fromStep Step the run resumed from, -1 for a fresh run
+    * @return	FILE* positioned at the end of the kept rows, NULL if the file could not be opened
+    */
+    FILE *openSeries(const char *file, int fromStep);
+
+	/**
+    * @brief	Appends one row of defect counts to a text file, writing the header if the file is empty
+    * @ingroup	helper
+    *
+    * @param	*buffer Char buffer for use by function internals. char[100] usually
+    * @param	*file Name of data file name for saving to
+    * @param	step Simulation step of the sample
+    * @param	num Number of vortices
+    * @param	defects Number of interior vortices with coordination other than six
+	* @param	*count Interior vortices by coordination number 0 to 9+
+	* @param	fromStep Step the run resumed from, -1 for a fresh run. See openSeries()
+    */
+    void writeOutDefects(char *buffer, char *file, int step, int num, unsigned int defects, unsigned int *count, int fromStep);
+
+	/**
+    * @brief	Appends one spectrum to a text file, one row per sample, writing the header of shell wavenumbers if the file is empty
+    * @ingroup	helper
+    *
+    * @param	*buffer Char buffer for use by function internals. char[100] usually
+    * @param	*file Name of data file name for saving to
+    * @param	step Simulation step of the sample
+    * @param	dk Shell width
+    * @param	bins Number of shells
+    * @param	total Integral of the spectrum, written after the step
+	* @param	*e Value of each shell
+	* @param	fromStep Step the run resumed from, -1 for a fresh run. See openSeries()
+    */
+    void writeOutSpectrum(char *buffer, const char *file, int step, double dk, int bins, double total, double *e, int fromStep);
+
+	/**
+    * @brief	Writes the azimuthal averages of the running mean and variance of a structure factor
+    * @ingroup	helper
+    *
+    * @param	*buffer Char buffer for use by function internals. char[100] usually
+    * @param	*file Name of data file name for saving to
+    * @param	dk Shell width
+    * @param	bins Number of shells
+	* @param	*mean Mean of each shell
+	* @param	*var Variance of each shell
+    * @param	step Index for the filename. file_step
+    */
+    void writeOutStructure(char *buffer, const char *file, double dk, int bins, double *mean, double *var, int step);
+
+	/**
+    * @brief	Writes flow fields as "X,Y,DENSITY,JX,JY,VX,VY,VORTICITY" rows, one per point of a regular grid
+    * @ingroup	helper
+    *
+    * @param	*buffer Char buffer for use by function internals. char[100] usually
+    * @param	*file Name of data file name for saving to
+    * @param	nx Points along x
+    * @param	ny Points along y
+    * @param	x0 x coordinate of the first point
+    * @param	y0 y coordinate of the first point
+    * @param	hx Spacing of the points along x
+    * @param	hy Spacing of the points along y
+	* @param	*density Density at each point
+	* @param	*current Current at each point
+	* @param	*velocity Velocity at each point
+	* @param	*vorticity Vorticity at each point
+    * @param	step Index for the filename. file_step
+    */
+    void writeOutFlow(char *buffer, const char *file, int nx, int ny, double x0, double y0, double hx, double hy, double *density, double2 *current, double2 *velocity, double *vorticity, int step);
+
 	/**
     * @brief	Writes the parameter file
     * @ingroup	helper
@@ -139,6 +384,77 @@ namespace FileIO {
     */
     void writeOutParam(char* buffer, Array arr, char *file);
 
+	/**
+	* Output policy modes for snapshot datasets.
+	*/
+	enum OutMode { OUT_FULL = 0, OUT_CROP, OUT_RADIUS, OUT_STRIDE, OUT_SPECTRAL };
+
+	/**
+	* Describes which part of the grid is written for a named dataset. nx, ny
+	* are the dimensions of the written grid, x0, y0 the first grid index kept.
+	*/
+	struct OutPolicy {
+		char name[32]; //Dataset the policy applies to, e.g. wfc_ev
+		int mode;
+		int x0, y0;
+		int nx, ny;
+		int stride;
+		int cx, cy; //Disk centre. OUT_RADIUS only
+		double radius; //Grid points. OUT_RADIUS only
+	};
+
+	/**
+    * @brief	Reads output policies, one per line: dataset mode args. Modes are
+	*			crop x0 y0 nx ny; radius r [cx cy]; stride s; spectral nx ny
+    * @ingroup	helper
+    *
+    * @param	*file Name of policy file
+	* @param	*pol Array to receive the policies
+	* @param	maxPol Length of pol. Policies past it are reported and ignored
+    * @param	xDim Size of x-grid, used to clamp the regions
+    * @param	yDim Size of y-grid, used to clamp the regions
+	* @return	Number of policies read, -1 if the file could not be read
+    */
+    int readOutPolicies(char *file, OutPolicy *pol, int maxPol, int xDim, int yDim);
+
+	/**
+    * @brief	Finds the policy for the named dataset
+    * @ingroup	helper
+    *
+    * @param	*name Dataset name
+	* @param	*pol Array of policies
+	* @param	numPol Length of pol
+	* @return	Matching policy, NULL if the dataset is written in full
+    */
+    OutPolicy *findOutPolicy(char *name, OutPolicy *pol, int numPol);
+
+	/**
+    * @brief	Gathers the region selected by a crop, radius or stride policy
+    * @ingroup	helper
+    *
+	* @param	&p Policy to apply
+    * @param	*data Full xDim*yDim grid
+    * @param	xDim Size of x-grid
+    * @param	yDim Size of y-grid
+	* @param	*out Buffer of at least p.nx*p.ny elements
+	* @return	out
+    */
+    double2 *applyOutPolicy(OutPolicy &p, double2 *data, int xDim, int yDim, double2 *out);
+
+	/**
+    * @brief	Writes the coordinate metadata for a policy to file_meta, in the same INI format as Params.dat
+    * @ingroup	helper
+    *
+    * @param	*buffer Char buffer for use by function internals. char[100] usually
+    * @param	*file Dataset name
+	* @param	&p Policy used for the dataset
+	* @param	*x X grid
+	* @param	*y Y grid
+    * @param	xDim Size of x-grid
+    * @param	yDim Size of y-grid
+    */
+    void writeOutMeta(char *buffer, char *file, OutPolicy &p, double *x, double *y, int xDim, int yDim);
+
 	/*
 	 * @brief	Opens and closes file. Nothing more. Nothing less.
 	 * @param	file Name of file to open
@@ -171,5 +487,54 @@ namespace FileIO {
 	* @param	step Index for the filename.
     */
     void writeOutAdjMat(char *buffer, char *file, double *mat, unsigned int *uids, int dim, int step);
+
+	/**
+	* Header of binary graph files. It is followed by the node UIDs
+	* (numVortices unsigned ints) and then, for an edge list, numEdges first
+	* ends, numEdges second ends and numEdges weights (doubles). For CSR it
+	* is followed by numVortices+1 row offsets, 2*numEdges column indices and
+	* 2*numEdges weights. Ends and columns are node indices into the UID
+	* table. Host byte order.
+	*/
+	struct GraphHeader {
+		char magic[4]; //"GPUG"
+		unsigned int version;
+		unsigned int format; //0 for an edge list, 1 for CSR
+		int step;
+		unsigned int numVortices;
+		unsigned int numEdges;
+	};
+
+	/**
+    * @brief	Writes a graph held as CSR as a list of its edges, each once, with their weights
+    * @ingroup	graph
+    *
+    * @param	*buffer Char buffer for use by function internals. char[100] usually
+    * @param	*file Name of data file name for saving to
+	* @param	*uids UID of each node
+	* @param	*rowPtr CSR row offsets, dim+1 of them
+	* @param	*colIdx CSR column indices
+	* @param	*colWeight CSR weights
+	* @param	dim Number of nodes
+	* @param	binary Binary file_step.bin if true, else text lines of "UID_A,UID_B,WEIGHT"
+	* @param	step Index for the filename.
+    */
+    void writeOutEdgeList(char *buffer, char *file, unsigned int *uids, const unsigned int *rowPtr, const unsigned int *colIdx, const double *colWeight, int dim, bool binary, int step);
+
+	/**
+    * @brief	Writes a graph in CSR form
+    * @ingroup	graph
+    *
+    * @param	*buffer Char buffer for use by function internals. char[100] usually
+    * @param	*file Name of data file name for saving to
+	* @param	*uids UID of each node
+	* @param	*rowPtr CSR row offsets, dim+1 of them
+	* @param	*colIdx CSR column indices
+	* @param	*colWeight CSR weights
+	* @param	dim Number of nodes
+	* @param	binary Binary file_step.bin if true, else text with the UIDs, offsets, indices and weights on one line each
+	* @param	step Index for the filename.
+    */
+    void writeOutCSR(char *buffer, char *file, unsigned int *uids, const unsigned int *rowPtr, const unsigned int *colIdx, const double *colWeight, int dim, bool binary, int step);
 }
 #endif
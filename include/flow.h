@@ -0,0 +1,105 @@
+///@cond LICENSE
+/*** flow.h - GPUE: Split Operator based GPU solver for Nonlinear
+Schrodinger Equation, Copyright (C) 2011-2015, Lee J. O'Riordan
+<loriordan@gmail.com>, Tadhg Morgan, Neil Crowley.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+///@endcond
+//##############################################################################
+/**
+ *  @file    flow.h
+ *  @author  Lee J. O'Riordan (mlxd)
+ *  @date    18/10/2026
+ *  @version 0.1
+ *
+ *  @brief Superfluid current, velocity and vorticity fields.
+ *
+ *  @section DESCRIPTION
+ *  Native version of matlab/velField.m and the finite differences of
+ *  py/vis.py and kinertrum. The gradient of psi is taken spectrally with
+ *  cuFFT, and the fields follow pointwise from psi and its gradient, so
+ *  there is no phase unwrapping. Fields may be decimated on the device
+ *  before they are copied back, for quiver plots.
+ */
+ //##############################################################################
+
+#ifndef FLOW_H
+#define FLOW_H
+#include <cuda_runtime.h>
+#include <cufft.h>
+
+namespace Flow {
+
+	/**
+	* Device buffers and FFT plan for one grid.
+	*/
+	class Fields {
+		private:
+			int xDim, yDim, stride, nx, ny;
+			double dkx, dky;
+			cufftHandle plan;
+			double2 *gpuA, *gpuB; //Spectral gradient of psi
+			double *gpuDensity, *gpuVorticity;
+			double2 *gpuCurrent, *gpuVelocity;
+
+		public:
+			/**
+			* @brief	Allocates the buffers
+			* @ingroup	gpu
+			* @param	xDim Length of X dimension
+			* @param	yDim Length of Y dimension
+			* @param	dx Grid spacing along x
+			* @param	dy Grid spacing along y
+			* @param	stride Keep every stride-th point along each axis. 1 for the full grid
+			*/
+			Fields(int xDim, int yDim, double dx, double dy, int stride);
+			~Fields();
+
+			/**
+			* @brief	Returns the dimensions of the decimated grid
+			* @ingroup	gpu
+			* @return	Points along x and y
+			*/
+			int2 getDims();
+
+			/**
+			* @brief	Computes the fields of a wavefunction and copies them back
+			* @ingroup	gpu
+			* @param	*gpuWfc Device wavefunction. Left unchanged
+			* @param	mass Particle mass
+			* @param	*density Output |psi|^2, or NULL
+			* @param	*current Output j = (hbar/m) Im(conj(psi) grad psi), or NULL
+			* @param	*velocity Output j/|psi|^2, or NULL. 0 where psi vanishes
+			* @param	*vorticity Output curl j, or NULL. The curl of the velocity itself is zero away from the cores
+			*/
+			void compute(double2 *gpuWfc, double mass, double *density, double2 *current, double2 *velocity, double *vorticity);
+	};
+}
+#endif
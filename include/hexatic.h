@@ -0,0 +1,114 @@
+///@cond LICENSE
+/*** hexatic.h - GPUE: Split Operator based GPU solver for Nonlinear
+Schrodinger Equation, Copyright (C) 2011-2015, Lee J. O'Riordan
+<loriordan@gmail.com>, Tadhg Morgan, Neil Crowley.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+///@endcond
+//##############################################################################
+/**
+ *  @file    hexatic.h
+ *  @author  Lee J. O'Riordan (mlxd)
+ *  @date    18/10/2026
+ *  @version 0.1
+ *
+ *  @brief Orientational order and Voronoi statistics of the vortex lattice.
+ *
+ *  @section DESCRIPTION
+ *  Native versions of matlab/psi6.m, g6_struct.m and voronoi2dCellColour.m.
+ *  The bond-orientational order psi6 of each vortex is taken over its graph
+ *  neighbours, g6(r) is binned from pair sums over a cell list, and the
+ *  Voronoi cells come from the Delaunay triangulation. Loops are OpenMP
+ *  parallel; used in-process by evolve() and by the gpue_order tool.
+ */
+ //##############################################################################
+
+#ifndef HEXATIC_H
+#define HEXATIC_H
+#include <cstdio>
+#include "lattice.h"
+
+namespace Hexatic {
+
+	/**
+	* Lattice-wide summary of one sample, over vortices off the hull.
+	*/
+	struct Summary {
+		int num; //Vortices included
+		double psi6Mean; //Mean of |psi6|
+		double psi6Global; //|mean of psi6|
+		double areaMean; //Mean Voronoi cell area
+		double areaStd; //Standard deviation of the cell areas
+		unsigned int sides[10]; //Cells by number of sides; entry 9 holds 9 or more
+	};
+
+	/**
+	* @brief	Computes psi6 = <exp(6i theta_ij)> over the graph neighbours j of each vortex i
+	* @ingroup	graph
+	* @param	&lattice Lattice with edges
+	* @param	*psi Output, one value per vortex. 0 for vortices without neighbours
+	*/
+	void psi6(LatticeGraph::Lattice &lattice, double2 *psi);
+
+	/**
+	* @brief	Bins Re(psi6_i conj(psi6_j)) over all vortex pairs closer than rMax, using a cell list
+	* @ingroup	graph
+	* @param	*v Vortices
+	* @param	*psi psi6 of each vortex
+	* @param	num Number of vortices
+	* @param	rMax Largest separation, in grid cells
+	* @param	bins Number of bins of width rMax/bins
+	* @param	*g6 Output, mean correlation in each bin. 0 for empty bins
+	* @param	*pairs Output, number of pairs in each bin
+	*/
+	void g6(const Vtx::Vortex *v, const double2 *psi, int num, double rMax, int bins, double *g6, double *pairs);
+
+	/**
+	* @brief	Summarises psi6 and the Voronoi cells over vortices off the hull
+	* @ingroup	graph
+	* @param	&lattice Lattice the values were computed on
+	* @param	*psi psi6 of each vortex
+	* @param	*area Voronoi cell area of each vortex
+	* @param	*sides Voronoi cell sides of each vortex
+	* @return	Summary
+	*/
+	Summary summarise(LatticeGraph::Lattice &lattice, const double2 *psi, const double *area, const unsigned int *sides);
+
+	/**
+	* @brief	Appends a summary row to a text file, writing the header if the file is empty
+	* @ingroup	graph
+	* @param	*file File name
+	* @param	step Simulation step, or file index for batch use
+	* @param	&s Summary
+	* @param	fromStep Step the run resumed from, -1 to start the file afresh. See FileIO::openSeries()
+	*/
+	void writeSummary(const char *file, int step, const Summary &s, int fromStep);
+}
+#endif
@@ -49,6 +49,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef KERNELS_H
 #define KERNELS_H
 #include<stdio.h>
+#include "vort.h"
 
 /**
 * @brief	Indexing of threads on grid
@@ -181,6 +182,198 @@ __global__ void scalarDiv2D(double2*, double2*);
 */
 __global__ void scalarDiv_wfcNorm(double2* in, double dr, double2* pSum, double2* out);
 
+/**
+* @brief	Gathers the lowest nx*ny Fourier modes of a transformed field into a smaller grid, for spectral downsampling
+* @ingroup	gpu
+* @param	in Forward transformed field, xDim*yDim in FFT order
+* @param	out Output of nx*ny modes in FFT order
+* @param	xDim Length of X dimension of in
+* @param	yDim Length of Y dimension of in
+* @param	nx Length of X dimension of out
+* @param	ny Length of Y dimension of out
+* @param	factor Scaling applied to each mode
+*/
+__global__ void fftCrop(double2* in, double2* out, int xDim, int yDim, int nx, int ny, double factor);
+
+/**
+* @brief	Marks plaquettes with non-zero phase winding inside the detection mask and appends them to a compact vortex list
+* @ingroup	gpu
+* @param	wfc Wavefunction
+* @param	span Per-row [x,y] range of plaquettes to search, from densitySpan
+* @param	xDim Length of X dimension
+* @param	vort Output vortex list. coords and wind are set
+* @param	count Number of vortices found. Must be zeroed before launch
+* @param	cap Length of vort. Vortices past cap are counted but not stored
+*/
+__global__ void findVortexGPU(double2* wfc, int2* span, int xDim, struct Vtx::Vortex* vort, int* count, int cap);
+
+/**
+* @brief	As findVortexGPU, but only over (2*win+1)^2 plaquettes centred on each previous vortex
+* @ingroup	gpu
+* @param	wfc Wavefunction
+* @param	span Detection mask row spans
+* @param	xDim Length of X dimension
+* @param	prev Previous vortex list
+* @param	numPrev Number of vortices in prev
+* @param	win Window half-width in grid cells
+* @param	stamp xDim*xDim claim array, so overlapping windows report a vortex once
+* @param	epoch Value unique to this launch, written to stamp
+* @param	vort Output vortex list
+* @param	count Number of vortices found. Must be zeroed before launch
+* @param	cap Length of vort
+*/
+__global__ void trackVortexWindow(double2* wfc, int2* span, int xDim, struct Vtx::Vortex* prev, int numPrev, int win, unsigned int* stamp, unsigned int epoch, struct Vtx::Vortex* vort, int* count, int cap);
+
+/**
+* @brief	Phase circulation around the edge of the detection mask, in units of 2pi. One thread per row
+* @ingroup	gpu
+* @param	wfc Wavefunction
+* @param	span Detection mask row spans
+* @param	xDim Length of X dimension
+* @param	sum Net winding, accumulated. Must be zeroed before launch
+*/
+__global__ void boundaryWinding(double2* wfc, int2* span, int xDim, int* sum);
+
+/**
+* @brief	Peak density of each row. One thread per row
+* @ingroup	gpu
+* @param	wfc Wavefunction
+* @param	xDim Length of X dimension
+* @param	rowMax Output, xDim values
+*/
+__global__ void rowDensityMax(double2* wfc, int xDim, double* rowMax);
+
+/**
+* @brief	Builds the vortex detection mask as one [first,last] plaquette range per row, from the first to the last plaquette inside the radius whose four corners all have density of at least thresh. Cores inside the condensate fall within the range
+* @ingroup	gpu
+* @param	wfc Wavefunction
+* @param	x X grid
+* @param	r2 Square of the search radius
+* @param	thresh Density threshold
+* @param	xDim Length of X dimension
+* @param	span Output, xDim-1 row spans. Empty rows have x > y
+*/
+__global__ void densitySpan(double2* wfc, double* x, double r2, double thresh, int xDim, int2* span);
+
+/**
+* @brief	Least-squares refinement of vortex cores found by findVortexGPU. Sets coordsD
+* @ingroup	gpu
+* @param	wfc Wavefunction
+* @param	vort Vortex list
+* @param	num Number of vortices in vort
+* @param	xDim Length of X dimension
+* @param	stencil Width of the square stencil fitted around each core, 2 or 4
+*/
+__global__ void lsFitGPU(double2* wfc, struct Vtx::Vortex* vort, int num, int xDim, int stencil);
+
+//##############################################################################
+/**
+ * Spectral derivatives, kinetic energy spectra, the density structure
+ * factor and flow fields. Launched over one thread per grid point unless
+ * noted.
+ */
+//##############################################################################
+
+/**
+* @brief	Wavenumber of an FFT index, 0 for the Nyquist mode of an even axis
+* @ingroup	gpu
+* @param	i Index along the axis
+* @param	n Length of the axis
+* @param	dk Wavenumber spacing, 2pi/(n*dx)
+* @return	Signed wavenumber
+*/
+__device__ double fftWavenumber(int i, int n, double dk);
+
+/**
+* @brief	Multiplies a forward transform by i*kx and i*ky, giving the transforms of the x and y derivatives
+* @ingroup	gpu
+* @param	in Forward transform of the field
+* @param	outX Output, transform of the x derivative. Must not alias in
+* @param	outY Output, transform of the y derivative. May alias in
+* @param	xDim Length of X dimension
+* @param	yDim Length of Y dimension
+* @param	dkx Wavenumber spacing along x
+* @param	dky Wavenumber spacing along y
+* @param	factor Scale applied to both outputs, e.g. 1/(xDim*yDim) for the inverse transform
+*/
+__global__ void specGradient(double2* in, double2* outX, double2* outY, int xDim, int yDim, double dkx, double dky, double factor);
+
+/**
+* @brief	Density-weighted velocity sqrt(n)v = (hbar/m) Im(conj(psi) grad psi)/|psi|, packed as ux + i uy
+* @ingroup	gpu
+* @param	wfc Wavefunction
+* @param	gradX x derivative of the wavefunction
+* @param	gradY y derivative of the wavefunction
+* @param	hbarM hbar/mass
+* @param	n Number of grid points
+* @param	out Output, ux + i uy. May alias gradX
+*/
+__global__ void packedVelocity(double2* wfc, double2* gradX, double2* gradY, double hbarM, int n, double2* out);
+
+/**
+* @brief	Sums |u_c(k)|^2 and |u_i(k)|^2 over each k-shell. One block per shell, with a power-of-two block and 2*blockDim doubles of shared memory
+* @ingroup	gpu
+* @param	w Forward transform of ux + i uy
+* @param	modes Grid indices of the modes of every shell in turn
+* @param	shellStart Offset of each shell in modes, gridDim.x + 1 values
+* @param	xDim Length of X dimension
+* @param	yDim Length of Y dimension
+* @param	dkx Wavenumber spacing along x
+* @param	dky Wavenumber spacing along y
+* @param	out Output, the compressible sum of each shell followed by the incompressible sums
+*/
+__global__ void kineticShells(double2* w, int* modes, int* shellStart, int xDim, int yDim, double dkx, double dky, double* out);
+
+/**
+* @brief	Density |psi|^2 of each grid point
+* @ingroup	gpu
+* @param	wfc Wavefunction
+* @param	n Number of grid points
+* @param	out Output density
+*/
+__global__ void densityField(double2* wfc, int n, double* out);
+
+/**
+* @brief	Adds one sample of S(k) = scale*|n_k|^2/n_0 to the running mean and summed squared deviation of each mode
+* @ingroup	gpu
+* @param	nk Real-to-complex transform of the density
+* @param	scale Normalisation, N*dx*dy for N particles
+* @param	samples Number of samples including this one
+* @param	n Number of stored modes, xDim*(yDim/2+1)
+* @param	mean Running mean of each mode
+* @param	m2 Summed squared deviation of each mode
+*/
+__global__ void structureAccumulate(double2* nk, double scale, int samples, int n, double* mean, double* m2);
+
+/**
+* @brief	Sums S(k) over each k-shell of the half spectrum, counting the modes that stand for k and -k twice. One block per shell, with a power-of-two block and blockDim doubles of shared memory
+* @ingroup	gpu
+* @param	nk Real-to-complex transform of the density
+* @param	modes Indices into nk of the modes of every shell in turn
+* @param	shellStart Offset of each shell in modes, gridDim.x + 1 values
+* @param	yDim Length of Y dimension of the real grid
+* @param	scale Normalisation, as structureAccumulate
+* @param	out Output, the sum of each shell
+*/
+__global__ void structureShells(double2* nk, int* modes, int* shellStart, int yDim, double scale, double* out);
+
+/**
+* @brief	Density, current j = (hbar/m) Im(conj(psi) grad psi), velocity j/n and vorticity curl j at every stride-th point along each axis. One thread per output point
+* @ingroup	gpu
+* @param	wfc Wavefunction
+* @param	gradX x derivative of the wavefunction
+* @param	gradY y derivative of the wavefunction
+* @param	xDim Length of X dimension
+* @param	yDim Length of Y dimension
+* @param	stride Decimation along each axis. 1 for the full grid
+* @param	hbarM hbar/mass
+* @param	density Output density
+* @param	current Output current, jx + i jy
+* @param	velocity Output velocity, vx + i vy. 0 where the density vanishes
+* @param	vorticity Output curl of the current
+*/
+__global__ void flowFields(double2* wfc, double2* gradX, double2* gradY, int xDim, int yDim, int stride, double hbarM, double* density, double2* current, double2* velocity, double* vorticity);
+
 //##############################################################################
 
 /**
@@ -45,6 +45,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *  Vortices are passed in as nodes, with edges created between them for
  *  generating graphs. Edges and nodes can be created as necessary. An adjacency
  *  matrix can also be output, with Mathematica input syntax in mind.
+ *  The graph is held in contiguous arrays with CSR adjacency; the Node and
+ *  Edge objects are built from them only when asked for.
  */
 //##############################################################################
 
@@ -55,9 +57,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <cmath>
 //#include <algorithm>
 #include <vector>
+#include <unordered_map>
 #include "node.h"
 #include "edge.h"
 #include "tracker.h"
+#include "delaunay.h"
 
 namespace LatticeGraph {
 
@@ -67,6 +71,29 @@ namespace LatticeGraph {
 	    std::vector <std::shared_ptr <Node> > vortices; //The vortices (nodes)
 	    std::vector <std::shared_ptr <Edge> > edges; //The edges
 
+	    /*
+	     * Arena: contiguous copies of the graph. Whichever of the arena and the
+	     * Node/Edge objects was modified last is authoritative, and the other
+	     * is rebuilt from it on demand in O(V+E).
+	     */
+	    std::vector <Vtx::Vortex> nodeData; //Vortex data by index
+	    std::vector <unsigned int> nodeUid; //Node UID by index
+	    std::vector <unsigned int> edgeA, edgeB; //Edge end indices
+	    std::vector <unsigned int> rowPtr, colIdx; //CSR adjacency, both directions
+	    std::vector <double> colWeight; //Intervortex distance of each CSR entry
+	    std::unordered_map <unsigned int, unsigned int> idxOfUid; //Node UID to index
+	    bool arenaOut; //Node/Edge objects modified since the arena was built
+	    bool nodesOut, edgesOut; //Arena modified since the Node/Edge objects were built
+	    bool csrOut; //Edges changed since the CSR was built
+	    Delaunay dt; //Triangulator, kept for its buffers
+	    std::vector <char> nodeHull; //Hull flags from the last triangulation
+
+	    void syncObjects();
+	    void touchObjects();
+	    void syncArena();
+	    void syncCSR();
+	    void indexUids();
+
     public:
 		/**
 		* @brief	Makes stuff exist
@@ -94,6 +121,72 @@ namespace LatticeGraph {
 		*/
 	    std::vector <std::shared_ptr <Edge> > &getEdges();
 
+//##############################################################################
+
+		/**
+		* @brief	Replaces the lattice with num vortices, without creating Node objects. Node UIDs are the vortex UIDs plus one.
+		* @ingroup	graph
+		* @param	*v Vortices
+		* @param	num Number of vortices
+		*/
+	    void setVortices(const Vtx::Vortex *v, unsigned int num);
+		/**
+		* @brief	Replaces the lattice with num vortices and updates the Delaunay edges from the last call, matching vortices by UID. Only the vortices that appeared, vanished or moved far enough to change the triangulation are re-triangulated.
+		* @ingroup	graph
+		* @param	*v Vortices
+		* @param	num Number of vortices
+		*/
+	    void updateVortices(const Vtx::Vortex *v, unsigned int num);
+		/**
+		* @brief	Removes all vortices and edges
+		* @ingroup	graph
+		*/
+	    void clear();
+		/**
+		* @brief	Returns the number of vortices
+		* @ingroup	graph
+		* @return	Number of vortices
+		*/
+	    unsigned int getNumVortices();
+		/**
+		* @brief	Returns the number of edges
+		* @ingroup	graph
+		* @return	Number of edges
+		*/
+	    unsigned int getNumEdges();
+		/**
+		* @brief	Returns the data of the vortex at index idx
+		* @ingroup	graph
+		* @param	idx Index of vortex
+		* @return	Vortex data
+		*/
+	    const Vtx::Vortex &getVortexData(unsigned int idx);
+		/**
+		* @brief	Returns the UID of the vortex at index idx
+		* @ingroup	graph
+		* @param	idx Index of vortex
+		* @return	Node UID
+		*/
+	    unsigned int getUidIdx(unsigned int idx);
+		/**
+		* @brief	Returns the CSR row offsets. Neighbours of vortex i are getColIdx()[getRowPtr()[i]] to getColIdx()[getRowPtr()[i+1]-1]
+		* @ingroup	graph
+		* @return	Vector of V+1 offsets
+		*/
+	    const std::vector<unsigned int> &getRowPtr();
+		/**
+		* @brief	Returns the CSR neighbour indices
+		* @ingroup	graph
+		* @return	Vector of 2E vortex indices
+		*/
+	    const std::vector<unsigned int> &getColIdx();
+		/**
+		* @brief	Returns the intervortex distance of each CSR entry
+		* @ingroup	graph
+		* @return	Vector of 2E distances
+		*/
+	    const std::vector<double> &getColWeight();
+
 //##############################################################################
 
 		/**
@@ -117,7 +210,7 @@ namespace LatticeGraph {
 		* @brief	Returns vortex index based on UID
 		* @ingroup	graph
 		* @param	uid UID of vortex
-		* @return	Index of vortex with UID uid
+		* @return	Index of vortex with UID uid, (unsigned) -1 if absent
 		*/
 	    unsigned int getVortexIdxUid(unsigned int uid);
 		/**
@@ -134,8 +227,7 @@ namespace LatticeGraph {
 		* @brief	Returns vortex based on UID
 		* @ingroup	graph
 		* @param	uid UID of vortex
-		* @return	Vortex with UID uid
-		* @bug		Fails for vortex UIDs that do not exist. Assumes they do.
+		* @return	Vortex with UID uid, empty if absent
 		*/
 	    std::shared_ptr<Node> getVortexUid(unsigned int uid);
 		/**
@@ -299,6 +391,42 @@ namespace LatticeGraph {
 		* @param	radius Radius cutoff for creating edge connections
 		*/
 	    void createEdges(double radius);
+		/**
+		* @brief	Replaces the edges with the Delaunay triangulation of the refined vortex positions
+		* @ingroup	graph
+		*/
+	    void createEdgesDelaunay();
+
+//##############################################################################
+
+		/**
+		* @brief	Returns the number of neighbours of the vortex at index idx
+		* @ingroup	graph
+		* @param	idx Index of vortex
+		* @return	Coordination number
+		*/
+	    unsigned int getCoordination(unsigned int idx);
+		/**
+		* @brief	Checks if the vortex at index idx was on the convex hull of the last triangulation
+		* @ingroup	graph
+		* @param	idx Index of vortex
+		* @return	True if on the hull, or left out as coincident
+		*/
+	    bool isOnHull(unsigned int idx);
+		/**
+		* @brief	Histogram of coordination numbers over vortices off the hull, as in defectTriangulation.m. Six is the defect-free lattice.
+		* @ingroup	graph
+		* @param	*count Array of 10 counts; entry 9 holds 9 or more neighbours
+		* @return	Number of interior vortices with coordination other than six
+		*/
+	    unsigned int countDefects(unsigned int *count);
+		/**
+		* @brief	Voronoi cell area and number of sides of each vortex, from the last Delaunay edges. Open cells at the hull, and all cells if the edges did not come from a triangulation, get 0 for both.
+		* @ingroup	graph
+		* @param	*area Cell areas, by vortex index
+		* @param	*sides Number of cell sides, by vortex index
+		*/
+	    void getVoronoi(double *area, unsigned int *sides);
 
 //##############################################################################
 
@@ -0,0 +1,130 @@
+///@cond LICENSE
+/*** paircorr.h - GPUE: Split Operator based GPU solver for Nonlinear
+Schrodinger Equation, Copyright (C) 2011-2015, Lee J. O'Riordan
+<loriordan@gmail.com>, Tadhg Morgan, Neil Crowley.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+///@endcond
+//##############################################################################
+/**
+ *  @file    paircorr.h
+ *  @author  Lee J. O'Riordan (mlxd)
+ *  @date    18/10/2026
+ *  @version 0.1
+ *
+ *  @brief Cell lists, pair-distance histograms and the pair-correlation function g(r).
+ *
+ *  @section DESCRIPTION
+ *  Replaces the all-pairs distance list of py/hist3d.py. Pairs are found
+ *  through a cell list with cells no smaller than the cut-off radius, so
+ *  only neighbouring cells are visited. Each OpenMP thread bins into its own
+ *  histogram, and the histograms are summed at the end. The same cell list
+ *  finds the distance-cutoff edges of the lattice graph.
+ */
+ //##############################################################################
+
+#ifndef PAIRCORR_H
+#define PAIRCORR_H
+#include <cuda_runtime.h>
+#include <vector>
+
+namespace PairCorr {
+
+	/**
+	* Points binned into square cells at least as wide as a cut-off radius,
+	* so every pair within the cut-off lies in the same or an adjacent cell.
+	*/
+	class CellList {
+		private:
+			int cx, cy;
+			std::vector<int> start, cellOf, sorted;
+
+		public:
+			/**
+			* @brief	Bins the points with a counting sort. The cell size is raised for sparse sets to keep the grid to ~4n cells.
+			* @ingroup	graph
+			* @param	*pos Point positions
+			* @param	num Number of points
+			* @param	radius Cut-off radius
+			*/
+			void build(const double2 *pos, int num, double radius);
+
+			/**
+			* @brief	Calls visit(jj) for every point jj > ii in the 3x3 cells around point ii. Safe to call from several threads.
+			* @ingroup	graph
+			* @param	ii Point index
+			* @param	visit Callable taking the index of the other point
+			*/
+			template <typename F>
+			void neighbours(int ii, F visit) const {
+				int ci = cellOf[ii]/cy, cj = cellOf[ii]%cy;
+				for(int a = (ci > 0) ? ci - 1 : 0; a <= ci + 1 && a < cx; ++a)
+					for(int b = (cj > 0) ? cj - 1 : 0; b <= cj + 1 && b < cy; ++b)
+						for(int k = start[a*cy + b]; k < start[a*cy + b + 1]; ++k)
+							if(sorted[k] > ii)
+								visit(sorted[k]);
+			}
+	};
+
+	/**
+	* @brief	Bins the separations of all point pairs closer than rMax, using a cell list
+	* @ingroup	graph
+	* @param	*pos Point positions
+	* @param	num Number of points
+	* @param	rMax Cut-off radius, in grid cells
+	* @param	bins Number of bins of width rMax/bins
+	* @param	*count Output, number of pairs in each bin
+	* @param	*w Optional complex weight of each point
+	* @param	*wsum Output if w is given, sum of Re(w_i conj(w_j)) over the pairs in each bin
+	*/
+	void histogram(const double2 *pos, int num, double rMax, int bins, double *count, const double2 *w = NULL, double *wsum = NULL);
+
+	/**
+	* @brief	Normalises a pair histogram by the ideal-gas pair count of each shell, giving g(r)
+	* @ingroup	graph
+	* @param	*count Pairs in each bin
+	* @param	num Number of points
+	* @param	area Area holding the points. The bounding box is a fair choice for a filled condensate
+	* @param	rMax Cut-off radius the histogram was taken with
+	* @param	bins Number of bins
+	* @param	*g Output, g(r) at each bin. May alias count
+	*/
+	void normalise(const double *count, int num, double area, double rMax, int bins, double *g);
+
+	/**
+	* @brief	Returns the area of the bounding box of a point set
+	* @ingroup	graph
+	* @param	*pos Point positions
+	* @param	num Number of points
+	* @return	Bounding box area, 0 for fewer than two points
+	*/
+	double boundingArea(const double2 *pos, int num);
+}
+#endif
@@ -0,0 +1,178 @@
+///@cond LICENSE
+/*** runfile.h - GPUE: Split Operator based GPU solver for Nonlinear
+Schrodinger Equation, Copyright (C) 2011-2015, Lee J. O'Riordan
+<loriordan@gmail.com>, Tadhg Morgan, Neil Crowley.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+///@endcond
+//##############################################################################
+/**
+ *  @file    runfile.h
+ *  @author  Lee J. O'Riordan (mlxd)
+ *  @date    18/10/2026
+ *  @version 0.1
+ *
+ *  @brief Tile-chunked container for the snapshots of a whole run.
+ *
+ *  @section DESCRIPTION
+ *  Each snapshot of a dataset is appended to a single file as a fixed-size
+ *  frame, with the grid stored as square tiles rather than rows. The reader
+ *  memory-maps the file, so extracting a point or a rectangle over many
+ *  steps only pages in the tiles that cover it.
+ */
+ //##############################################################################
+
+#ifndef RUNFILE_H
+#define RUNFILE_H
+#include <cuda_runtime.h>
+
+namespace RunFile {
+
+	/**
+	* Header at the start of a run container.
+	*/
+	struct RunHeader {
+		char magic[4]; //"GPUR"
+		unsigned int version;
+		int xDim;
+		int yDim;
+		int tile; //Tile edge length in grid points
+		unsigned int elemSize;
+	};
+
+	/**
+	* Header at the start of each frame. The tiles follow in row-major tile
+	* order, each tile*tile elements, zero-padded at the grid edges.
+	*/
+	struct FrameHeader {
+		long long step;
+		long long reserved;
+	};
+
+	/**
+	* @brief	Appends one snapshot to a run container, creating it if needed. The first append to a container by this process starts the run: frames from an earlier run at or after fromStep are cut, along with any partial frame a crash left behind.
+	* @ingroup	helper
+	* @param	*file Name of the run container
+	* @param	*data Row-major xDim*yDim grid
+	* @param	xDim Size of x-grid
+	* @param	yDim Size of y-grid
+	* @param	tile Tile edge length. Ignored if the container already exists
+	* @param	step Simulation step of the snapshot
+	* @param	fromStep Step a resumed run restarts from, or -1 to discard every earlier frame
+	* @return	0 on success, -1 if the file could not be written, its grid differs, or it is not a whole number of frames
+	*/
+	int appendFrame(char *file, double2 *data, int xDim, int yDim, int tile, int step, int fromStep);
+
+//##############################################################################
+	/**
+	* Read-only, memory-mapped view of a run container.
+	*/
+	class Reader {
+		private:
+			char *map;
+			size_t mapLen;
+			RunHeader h;
+			int tilesX, tilesY;
+			size_t frameLen;
+			int frames;
+
+			double2 *tileAt(int frame, int ti, int tj);
+
+		public:
+			/**
+			* @brief	Maps the run container. Containers that are not a whole number of frames are rejected.
+			* @ingroup	helper
+			* @param	*file Name of the run container
+			*/
+			Reader(char *file);
+			~Reader();
+
+			/**
+			* @brief	Checks the container was mapped and has a valid header
+			* @ingroup	helper
+			* @return	true if usable
+			*/
+			bool isOpen();
+
+			/**
+			* @brief	Returns the grid dimensions stored in the header
+			* @ingroup	helper
+			* @return	int2 of xDim, yDim
+			*/
+			int2 getDims();
+
+			/**
+			* @brief	Returns the number of complete frames in the container
+			* @ingroup	helper
+			* @return	Number of frames
+			*/
+			int getFrames();
+
+			/**
+			* @brief	Returns the simulation step of a frame
+			* @ingroup	helper
+			* @param	frame Frame index
+			* @return	Step of the frame
+			*/
+			long long getStep(int frame);
+
+			/**
+			* @brief	Finds the first frame at or after a step. Frames are appended in step order.
+			* @ingroup	helper
+			* @param	step Step to search for
+			* @return	Frame index, getFrames() if every frame is earlier
+			*/
+			int findFrame(long long step);
+
+			/**
+			* @brief	Reads a single grid point of a frame
+			* @ingroup	helper
+			* @param	frame Frame index
+			* @param	i X index
+			* @param	j Y index
+			* @return	Value at (i,j)
+			*/
+			double2 readPoint(int frame, int i, int j);
+
+			/**
+			* @brief	Reads a rectangle of a frame, touching only the tiles that cover it
+			* @ingroup	helper
+			* @param	frame Frame index
+			* @param	x0 First X index
+			* @param	y0 First Y index
+			* @param	nx Number of points along X
+			* @param	ny Number of points along Y
+			* @param	*out Row-major nx*ny output
+			* @return	0 on success, -1 if the rectangle leaves the grid
+			*/
+			int readRegion(int frame, int x0, int y0, int nx, int ny, double2 *out);
+	};
+}
+#endif
@@ -0,0 +1,202 @@
+///@cond LICENSE
+/*** spectrum.h - GPUE: Split Operator based GPU solver for Nonlinear
+Schrodinger Equation, Copyright (C) 2011-2015, Lee J. O'Riordan
+<loriordan@gmail.com>, Tadhg Morgan, Neil Crowley.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+///@endcond
+//##############################################################################
+/**
+ *  @file    spectrum.h
+ *  @author  Lee J. O'Riordan (mlxd)
+ *  @date    18/10/2026
+ *  @version 0.1
+ *
+ *  @brief Kinetic energy spectra and the density structure factor.
+ *
+ *  @section DESCRIPTION
+ *  Native versions of py/observables.py kinertrum and dens_struct_fact, and
+ *  matlab/quKineticSpec.m. The gradient of psi is taken spectrally with
+ *  cuFFT, so no phase unwrapping is needed. The density-weighted velocity
+ *  sqrt(n)v is transformed once as ux + i uy and split along and across k.
+ *  The structure factor keeps running moments of every mode on the device,
+ *  so memory does not grow with the run. The modes are sorted by k-shell
+ *  once, and every shell is summed in a single launch.
+ */
+ //##############################################################################
+
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+#include <vector>
+#include <cuda_runtime.h>
+#include <cufft.h>
+
+namespace Spectrum {
+
+	/**
+	* Device buffers, FFT plan and k-shell tables for one grid.
+	*/
+	class Engine {
+		private:
+			int xDim, yDim, bins;
+			double dx, dy, dkx, dky, dk;
+			cufftHandle plan;
+			double2 *gpuA, *gpuB; //Scratch grids
+			int *gpuModes, *gpuShellStart; //Modes sorted by shell; the last shell holds the modes past bins*dk
+			double *gpuShells;
+			std::vector<double> shells;
+
+		public:
+			/**
+			* @brief	Allocates the buffers and sorts the modes into shells of width max(dkx,dky)
+			* @ingroup	gpu
+			* @param	xDim Length of X dimension
+			* @param	yDim Length of Y dimension
+			* @param	dx Grid spacing along x
+			* @param	dy Grid spacing along y
+			* @param	bins Number of shells. 0 for every shell inside the Nyquist wavenumber of the coarser axis
+			*/
+			Engine(int xDim, int yDim, double dx, double dy, int bins);
+			~Engine();
+
+			/**
+			* @brief	Returns the number of shells
+			* @ingroup	gpu
+			* @return	Number of shells
+			*/
+			int getBins();
+
+			/**
+			* @brief	Returns the shell width
+			* @ingroup	gpu
+			* @return	Shell width in inverse length
+			*/
+			double getShellWidth();
+
+			/**
+			* @brief	Computes the kinetic energy spectra E(k), normalised so that sum(E(k))*dk gives the energy in the shells
+			* @ingroup	gpu
+			* @param	*gpuWfc Device wavefunction. Left unchanged
+			* @param	mass Particle mass
+			* @param	*ec Output, compressible E(k) of each shell
+			* @param	*ei Output, incompressible E(k) of each shell
+			* @param	&ecTotal Output, compressible energy over all modes
+			* @param	&eiTotal Output, incompressible energy over all modes
+			*/
+			void kinetic(double2 *gpuWfc, double mass, double *ec, double *ei, double &ecTotal, double &eiTotal);
+	};
+
+	/**
+	* Running mean and variance of the density structure factor
+	* S(k) = N|n_k|^2/n_0 over the samples of a run, from the real-to-complex
+	* transform of |psi|^2. Only the xDim*(yDim/2+1) stored modes are kept.
+	*/
+	class StructureFactor {
+		private:
+			int xDim, yDim, yHalf, bins, samples;
+			double dx, dy, dk, num;
+			cufftHandle plan;
+			double *gpuDensity, *gpuMean, *gpuM2, *gpuShells;
+			double2 *gpuNk;
+			int *gpuModes, *gpuShellStart; //Stored modes sorted by shell, without k = 0
+			std::vector<int> shellOf; //Shell of each stored mode, -1 for k = 0
+			std::vector<double> weight, shells; //Modes in each shell, counting k and -k
+
+		public:
+			/**
+			* @brief	Allocates the buffers and sorts the stored modes into shells of width max(dkx,dky)
+			* @ingroup	gpu
+			* @param	xDim Length of X dimension
+			* @param	yDim Length of Y dimension
+			* @param	dx Grid spacing along x
+			* @param	dy Grid spacing along y
+			* @param	bins Number of shells. 0 for every shell inside the Nyquist wavenumber of the coarser axis
+			* @param	num Number of particles N
+			*/
+			StructureFactor(int xDim, int yDim, double dx, double dy, int bins, double num);
+			~StructureFactor();
+
+			/**
+			* @brief	Returns the number of shells
+			* @ingroup	gpu
+			* @return	Number of shells
+			*/
+			int getBins();
+
+			/**
+			* @brief	Returns the shell width
+			* @ingroup	gpu
+			* @return	Shell width in inverse length
+			*/
+			double getShellWidth();
+
+			/**
+			* @brief	Returns the number of samples accumulated
+			* @ingroup	gpu
+			* @return	Number of samples
+			*/
+			int getSamples();
+
+			/**
+			* @brief	Adds one sample to the running moments and returns its azimuthal average
+			* @ingroup	gpu
+			* @param	*gpuWfc Device wavefunction. Left unchanged
+			* @param	*profile Output, mean S(k) over each shell
+			* @param	&total Output, integral of S(k) d^2k/(2pi)^2 over all k != 0
+			*/
+			void accumulate(double2 *gpuWfc, double *profile, double &total);
+
+			/**
+			* @brief	Copies back the running mean and variance of every stored mode
+			* @ingroup	gpu
+			* @param	*mean Output, xDim*(yDim/2+1) values, or NULL
+			* @param	*var Output, sample variance of each mode, or NULL
+			* @param	*meanProfile Output, azimuthal average of the mean over each shell, or NULL
+			* @param	*varProfile Output, azimuthal average of the variance over each shell, or NULL
+			*/
+			void getMoments(double *mean, double *var, double *meanProfile, double *varProfile);
+
+			/**
+			* @brief	Copies back the raw running moments, for checkpointing
+			* @ingroup	gpu
+			* @param	*moments Output, xDim*(yDim/2+1) means followed by as many sums of squared deviations
+			*/
+			void getState(double *moments);
+
+			/**
+			* @brief	Restores running moments saved by getState
+			* @ingroup	gpu
+			* @param	*moments Means followed by sums of squared deviations, as from getState
+			* @param	samples Number of samples they hold
+			*/
+			void setState(double *moments, int samples);
+	};
+}
+#endif
@@ -142,6 +142,77 @@ int isError(int result, char* c); //Checks to see if an error has occurred.
 */
 void parSum(double2* gpuWfc, double2* gpuParSum, int xDim, int yDim, int threads);
 
+/**
+* @brief	Writes a wavefunction snapshot, reduced by the output policy for the dataset if one is set
+* @ingroup	data
+* @param	fileName Dataset name
+* @param	gpuWfc Device wavefunction, used for spectral downsampling
+* @param	hostWfc Host buffer for the wavefunction. Filled from gpuWfc unless the dataset is spectrally downsampled
+* @param	step Index for the filename
+*/
+void writeSnapshot(char *fileName, double2 *gpuWfc, double2 *hostWfc, int step);
+
+/**
+* @brief	Writes the density, current, velocity and vorticity of the device wavefunction, decimated by flow_stride
+* @ingroup	data
+* @param	fileName Dataset name. The fields go to fileName_flow_step
+* @param	gpuWfc Device wavefunction
+* @param	step Index for the filename
+*/
+void writeFlow(char *fileName, double2 *gpuWfc, int step);
+
+/**
+* @brief	Finds vortices on the device and returns only the compact, least-squares refined list in grid order
+* @ingroup	data
+* @param	gpuWfc Device wavefunction
+* @param	radius Vortex search radius in condensate
+* @param	vortCoords Host array for the vortex list
+* @param	cap Length of vortCoords
+* @return	Number of vortices found. Only the first cap are written if this exceeds cap
+*/
+int findVortexDevice(double2 *gpuWfc, double radius, struct Vtx::Vortex *vortCoords, int cap);
+
+/**
+* @brief	Finds vortices only near their previous positions, on the device
+* @ingroup	data
+* @param	gpuWfc Device wavefunction
+* @param	prev Vortices from the last sample
+* @param	numPrev Number of vortices in prev
+* @param	vortCoords Host array for the vortex list
+* @param	cap Length of vortCoords
+* @return	Number of vortices found, or -1 if a full scan is needed
+*/
+int trackVortexDevice(double2 *gpuWfc, struct Vtx::Vortex *prev, int numPrev, struct Vtx::Vortex *vortCoords, int cap);
+
+/**
+* @brief	Rebuilds the device vortex search mask from the density, limited to the given radius
+* @ingroup	data
+* @param	gpuWfc Device wavefunction
+* @param	radius Vortex search radius in condensate
+*/
+void densityMask(double2 *gpuWfc, double radius);
+
+/**
+* @brief	Refines device vortices by least squares and copies them to the host in grid order
+* @ingroup	data
+* @param	gpuWfc Device wavefunction
+* @param	gpuVort Device vortex list
+* @param	num Number of vortices in gpuVort
+* @param	vortCoords Host array for the vortex list
+* @param	cap Length of vortCoords
+*/
+void fetchVortices(double2 *gpuWfc, struct Vtx::Vortex *gpuVort, int num, struct Vtx::Vortex *vortCoords, int cap);
+
+/**
+* @brief	Resamples the device wavefunction on a coarser nx*ny grid by Fourier truncation
+* @ingroup	data
+* @param	gpuWfc Device wavefunction
+* @param	nx Length of X dimension of the output grid
+* @param	ny Length of Y dimension of the output grid
+* @param	out Host array of nx*ny elements for the result
+*/
+void spectralDownsample(double2 *gpuWfc, int nx, int ny, double2 *out);
+
 /**
 * @brief	Creates the optical lattice to match the vortex lattice constant
 * @ingroup	data
@@ -72,18 +72,10 @@ namespace Tracker {
 	 */
 
 
-    /**
-	 * Values from solving Ax=b for vortex least squares core finder.
-	 */
-    static const double lsq[3][4] = {{-0.5, 0.5,  -0.5, 0.5},
-                                     {-0.5, -0.5, 0.5,  0.5},
-                                     {0.75, 0.25, 0.25, -0.25}};
-
-
 	/**
 	* @brief	Find vortex locations in the condensate.
 	* @ingroup	data
-	* @param	marker Matrix for vortex locations to nearest grid point
+	* @param	marker Matrix for vortex locations to nearest grid point. Set to the signed winding of each core
 	* @param	wfc Wavefunction
 	* @param	radius Vortex search radius in condensate
 	* @param	xDim Length of X dimension
@@ -195,8 +187,22 @@ namespace Tracker {
 	* @param	wfc Wavefunction
 	* @param	numVort Number of vortices
 	* @param	xDim Length of X dimension
+	* @param	stencil Width of the square stencil fitted around each core, 2 or 4
+	*/
+    void lsFit(struct Vtx::Vortex *vortCoords, double2 *wfc, int numVort, int xDim, int stencil);
+
+	/**
+	* @brief	Links vortices between frames by gated minimum-displacement assignment, handling births and deaths
+	* @ingroup	data
+	* @param	vPrev Vortices of the previous frame, with UIDs set
+	* @param	numPrev Number of previous vortices
+	* @param	vCur Vortices of the current frame. UIDs are set on return
+	* @param	numCur Number of current vortices
+	* @param	gate Largest distance in grid units a vortex may move between frames. Must be positive
+	* @param	nextUid Next unused UID. Advanced for every birth
+	* @return	Number of current vortices linked to a previous one
 	*/
-    void lsFit(struct Vtx::Vortex *vortCoords, double2 *wfc, int numVort, int xDim);
+    int linkVortices(struct Vtx::Vortex *vPrev, int numPrev, struct Vtx::Vortex *vCur, int numCur, double gate, unsigned int *nextUid);
 }
 
 #endif
@@ -0,0 +1,235 @@
+///@cond LICENSE
+/*** trajfile.h - GPUE: Split Operator based GPU solver for Nonlinear
+Schrodinger Equation, Copyright (C) 2011-2015, Lee J. O'Riordan
+<loriordan@gmail.com>, Tadhg Morgan, Neil Crowley.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+///@endcond
+//##############################################################################
+/**
+ *  @file    trajfile.h
+ *  @author  Lee J. O'Riordan (mlxd)
+ *  @date    18/10/2026
+ *  @version 0.1
+ *
+ *  @brief Streaming, columnar store of per-vortex trajectories.
+ *
+ *  @section DESCRIPTION
+ *  The tracker appends (uid, step, x, y, winding) records as the run
+ *  progresses. Records are buffered into blocks, sorted by uid and step, and
+ *  each column is delta-encoded as variable-length integers. A uid index is
+ *  written on close, so the reader decodes only the blocks holding the
+ *  requested vortex.
+ */
+ //##############################################################################
+
+#ifndef TRAJFILE_H
+#define TRAJFILE_H
+#include <cstdio>
+#include <vector>
+#include "vort.h"
+
+namespace TrajFile {
+
+	/**
+	* Header at the start of a trajectory file.
+	*/
+	struct TrajHeader {
+		char magic[4]; //"GPUT"
+		unsigned int version;
+		double scale; //Positions are stored as round(x*scale)
+	};
+
+	/**
+	* Header at the start of each block. The payload holds the uid, step, x,
+	* y and winding columns in turn.
+	*/
+	struct BlockHeader {
+		char tag[4]; //"BLK0"
+		unsigned int numRec;
+		unsigned int numBytes; //Payload length
+		unsigned int uidMin, uidMax;
+		int stepMin, stepMax;
+	};
+
+	/**
+	* Trailer at the end of a closed file, pointing back to the uid index.
+	* The index holds the tag "IDX0", the block count and offsets, the UID
+	* bound, then for each UID its block count and block numbers.
+	*/
+	struct TrajTrailer {
+		long long indexOffset;
+		char magic[4]; //"GPUI"
+		unsigned int reserved;
+	};
+
+	/**
+	* One sample of one vortex.
+	*/
+	struct Record {
+		unsigned int uid;
+		int step;
+		double x, y;
+		int wind;
+	};
+
+//##############################################################################
+	/**
+	* Appends samples to a trajectory file.
+	*/
+	class Writer {
+		private:
+			FILE *f;
+			double scale;
+			int blockLen;
+			std::vector<Record> pending;
+			std::vector<long long> offsets; //File offset of each block
+			std::vector<std::vector<unsigned int> > blocksOfUid; //Blocks holding each uid
+
+			void flush();
+
+		public:
+			Writer();
+			~Writer();
+
+			/**
+			* @brief	Opens a trajectory file for appending
+			* @ingroup	helper
+			* @param	*file Name of the trajectory file
+			* @param	fromStep Start a new file if negative. Otherwise keep the existing samples before this step and append after them.
+			* @param	blockLen Records per block
+			* @return	0 on success, -1 if the file could not be opened or is not a trajectory file
+			*/
+			int open(char *file, int fromStep, int blockLen);
+
+			/**
+			* @brief	Checks a file is open for writing
+			* @ingroup	helper
+			* @return	true if open
+			*/
+			bool isOpen();
+
+			/**
+			* @brief	Appends the linked vortices of one sample
+			* @ingroup	helper
+			* @param	*v Vortices with their UIDs
+			* @param	num Number of vortices
+			* @param	step Simulation step of the sample
+			*/
+			void append(const Vtx::Vortex *v, int num, int step);
+
+			/**
+			* @brief	Writes the remaining samples and the uid index, then closes the file
+			* @ingroup	helper
+			* @return	0 on success, -1 if the file could not be written
+			*/
+			int close();
+	};
+
+//##############################################################################
+	/**
+	* Reads trajectories back from a trajectory file.
+	*/
+	class Reader {
+		private:
+			FILE *f;
+			TrajHeader h;
+			std::vector<long long> offsets;
+			std::vector<BlockHeader> headers;
+			std::vector<std::vector<unsigned int> > blocksOfUid; //Empty if the file was not closed
+
+			int readBlock(int b, std::vector<Record> &out);
+
+		public:
+			/**
+			* @brief	Opens a trajectory file and loads its uid index. Files left unclosed by a crash are indexed from the block uid ranges instead.
+			* @ingroup	helper
+			* @param	*file Name of the trajectory file
+			*/
+			Reader(char *file);
+			~Reader();
+
+			/**
+			* @brief	Checks the file was opened and has a valid header
+			* @ingroup	helper
+			* @return	true if usable
+			*/
+			bool isOpen();
+
+			/**
+			* @brief	Returns the number of blocks in the file
+			* @ingroup	helper
+			* @return	Number of blocks
+			*/
+			int getBlocks();
+
+			/**
+			* @brief	Returns one past the largest UID in the file
+			* @ingroup	helper
+			* @return	UID bound
+			*/
+			unsigned int getUidBound();
+
+			/**
+			* @brief	Reads the full history of one vortex, decoding only the blocks that hold it
+			* @ingroup	helper
+			* @param	uid UID of the vortex
+			* @param	&out Samples in step order
+			* @return	Number of samples, -1 on a read error
+			*/
+			int getTrajectory(unsigned int uid, std::vector<Record> &out);
+
+			/**
+			* @brief	Reads every sample in the file
+			* @ingroup	helper
+			* @param	&out Samples in block order, sorted by uid and step within each block
+			* @return	Number of samples, -1 on a read error
+			*/
+			int getAll(std::vector<Record> &out);
+
+			/**
+			* @brief	Appends the samples of one block, for streaming through a file in block order
+			* @ingroup	helper
+			* @param	b Block number
+			* @param	&out Samples are appended, sorted by uid and step
+			* @return	0 on success, -1 on a read error
+			*/
+			int getBlock(int b, std::vector<Record> &out);
+
+			/**
+			* @brief	Returns the first step held by a block. Blocks are written in step order, so every step before this one is complete once the earlier blocks are read
+			* @ingroup	helper
+			* @param	b Block number
+			* @return	Smallest step in the block, INT_MAX past the last block
+			*/
+			int getStepMin(int b);
+	};
+}
+#endif
@@ -37,7 +37,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *  @date    12/11/2015
  *  @version 0.1
  *
- *  @brief Class for keeping track of vortices. Implementation TBC
+ *  @brief Class for keeping track of vortices.
  *
  *  @section DESCRIPTION
  *  Each vortex is treated as a struct of position, winding, and least-squares
@@ -49,87 +49,183 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef GPUE_1_VORT_H
 #define GPUE_1_VORT_H
 
-#include <memory>
-#include <list>
+#include <vector>
+#include <cstdio>
 #include<cuda.h>
 #include<cuda_runtime.h>
 
-//@todo Everything, as nothing is implemented in this class; struct Vortex is used though.
 namespace Vtx {
 
 	/**
 	* Maintains vortex index in grid and least-squares calculated values
-	* with winding/direction of vortex rotation.
+	* with winding/direction of vortex rotation. uid persists across frames
+	* once assigned by Tracker::linkVortices.
 	*/
     struct Vortex {
 	    int2 coords;
 	    double2 coordsD;
 	    int wind;
+	    unsigned int uid;
     };
 
 //##############################################################################
 	/**
-	* Vortex list for storing and retrieving vortices and associated values
+	* Vortex list for storing and retrieving vortices and associated values.
+	* Every vortex ever seen keeps a slot, stored as parallel arrays, along with
+	* its birth and death steps. Slots are looked up from UIDs in O(1). Storage
+	* only grows, so steady-state updates do not allocate.
 	*/
 	class VtxList {
 		private:
-			std::list< std::shared_ptr<Vortex> > vortices;
+			std::vector<int2> coords;
+			std::vector<double2> coordsD;
+			std::vector<int> wind;
+			std::vector<unsigned int> uid;
+			std::vector<char> active;
+			std::vector<int> birth, death;
+			std::vector<int> slotOfUid; //Slot for each UID, -1 if unseen
+			std::vector<int> activeSlots; //Slots of live vortices, in last update order
+			std::vector<int> seen; //Update counter at which each slot was last seen
+			int updates, born, died;
+			unsigned int maxUid;
+
 		public:
+			VtxList();
+
+			/**
+			* @brief	Records one frame of linked vortices. New UIDs open slots born at step. Live vortices missing from the frame die at step
+			* @ingroup	vtx
+			* @param	v Vortices with UIDs set
+			* @param	num Number of vortices in v
+			* @param	step Simulation step of the frame
+			*/
+			void update(const Vortex *v, int num, int step);
+
+			/**
+			* @brief	Number of slots, live or dead
+			* @ingroup	vtx
+			* @return	Number of vortices ever recorded
+			*/
+			int size() const;
+
 			/**
-			* @brief	Returns a reference to the vortex list
+			* @brief	Number of live vortices
 			* @ingroup	vtx
-			* @return	Reference to vortex list
+			* @return	Live vortex count
 			*/
-			std::list< std::shared_ptr<Vortex> > &getVortices();
+			int numActive() const;
 
 			/**
-			* @brief	Returns a reference to the vortex list
+			* @brief	Births and deaths seen by the last update
 			* @ingroup	vtx
-			* @return	Reference to vortex list
+			* @param	b Receives the number of births
+			* @param	d Receives the number of deaths
 			*/
-			std::shared_ptr<Vortex> get_Uid();
+			void lastChanges(int &b, int &d) const;
 
 			/**
-			* @brief	Returns a shared_ptr to the vortex by an index
+			* @brief	Returns the vortex with the given UID
 			* @ingroup	vtx
-			* @return	shared_ptr<Vortex> Shared pointer to vortex by index
+			* @param	u Vortex UID. Must have been recorded
+			* @return	Vortex in its last recorded state
 			*/
-			std::shared_ptr<Vortex> get_Idx();
+			Vortex get_Uid(unsigned int u) const;
 
 			/**
-			* @brief	Returns an index based upon a given vortex UID
+			* @brief	Returns the vortex in a slot
 			* @ingroup	vtx
-			* @return	unsigned int Vortex index for UID
+			* @param	idx Slot index
+			* @return	Vortex in its last recorded state
 			*/
-			unsigned int getIdx_Uid();
+			Vortex get_Idx(int idx) const;
+
+			/**
+			* @brief	Returns the slot for a given vortex UID
+			* @ingroup	vtx
+			* @param	u Vortex UID
+			* @return	Slot index, or -1 if the UID has not been recorded
+			*/
+			int getIdx_Uid(unsigned int u) const;
 
 			/**
 			* @brief	Returns the largest UID given
 			* @ingroup	vtx
 			* @return	unsigned int Largest vortex UID
 			*/
-			unsigned int getMax_Uid();
+			unsigned int getMax_Uid() const;
 
 			/**
-			* @brief	Returns index of vortex with shortest coordinate distance from current vortex
+			* @brief	Returns the slot of the live vortex nearest to v
 			* @ingroup	vtx
-			* @return	unsigned int Vortex index for shortest distance
+			* @param	v Vortex to compare against. coordsD is used
+			* @return	Slot index, or -1 if there are no live vortices
 			*/
-			unsigned int getIdx_MinDist();
+			int getIdx_MinDist(const Vortex &v) const;
 
 			/**
 			* @brief	In-place swap of the UID for the two given vortices
 			* @ingroup	vtx
-			* @param	v1 Shared pointer of Vortex v1
-			* @param	v2 Shared pointer of Vortex v2
+			* @param	u1 UID of the first vortex
+			* @param	u2 UID of the second vortex
 			*/
-			void swapUid(std::shared_ptr<Vortex> v1, std::shared_ptr<Vortex> v2);
+			void swapUid(unsigned int u1, unsigned int u2);
 
 			/**
 			* @brief	Turns vortex activation off. Useful if vortex no longer exists in condensate.
 			* @ingroup	vtx
+			* @param	u Vortex UID
+			* @param	step Step of death
+			*/
+			void vortOff(unsigned int u, int step);
+
+			/**
+			* @brief	Checks whether a slot holds a live vortex
+			* @ingroup	vtx
+			* @param	idx Slot index
+			* @return	true if live
+			*/
+			bool isActive(int idx) const;
+
+			/**
+			* @brief	Step at which the vortex in a slot was first recorded
+			* @ingroup	vtx
+			* @param	idx Slot index
+			* @return	Birth step
+			*/
+			int getBirth(int idx) const;
+
+			/**
+			* @brief	Step at which the vortex in a slot was last missing
+			* @ingroup	vtx
+			* @param	idx Slot index
+			* @return	Death step, or -1 if still live
+			*/
+			int getDeath(int idx) const;
+
+			/**
+			* @brief	Writes the live vortices, in last update order, to an array
+			* @ingroup	vtx
+			* @param	out Output array
+			* @param	cap Length of out
+			* @return	Number of live vortices. At most cap are written
+			*/
+			int getActive(Vortex *out, int cap) const;
+
+			/**
+			* @brief	Writes every slot to an open binary file
+			* @ingroup	vtx
+			* @param	f File to write to
+			* @return	0 on success, -1 otherwise
+			*/
+			int write(FILE *f) const;
+
+			/**
+			* @brief	Replaces the list with one stored by write
+			* @ingroup	vtx
+			* @param	f File to read from
+			* @return	0 on success, -1 otherwise
 			*/
-			void vortOff();
+			int read(FILE *f);
 	};
 }
 //##############################################################################
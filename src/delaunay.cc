@@ -0,0 +1,734 @@
+/*** delaunay.cc - GPUE: Split Operator based GPU solver for Nonlinear 
+Schrodinger Equation, Copyright (C) 2011-2015, Lee J. O'Riordan 
+<loriordan@gmail.com>, Tadhg Morgan, Neil Crowley. 
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without 
+modification, are permitted provided that the following conditions are 
+met:
+
+1. Redistributions of source code must retain the above copyright 
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright 
+notice, this list of conditions and the following disclaimer in the 
+documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its 
+contributors may be used to endorse or promote products derived from 
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, 
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+//######################################################################################################################
+
+#include "../include/delaunay.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace LatticeGraph;
+
+/***
+ * Position of (x,y) along a Hilbert curve on a 2^16 x 2^16 grid.
+ */
+static unsigned int hilbertIdx(unsigned int x, unsigned int y){
+	unsigned int d = 0;
+	for(unsigned int s = 1u << 15; s > 0; s >>= 1){
+		unsigned int rx = (x & s) > 0, ry = (y & s) > 0;
+		d += s*s*((3*rx) ^ ry);
+		if(ry == 0){
+			if(rx == 1){
+				x = 0xFFFF - x;
+				y = 0xFFFF - y;
+			}
+			std::swap(x, y);
+		}
+	}
+	return d;
+}
+
+/***
+ * Fixed sub-grid offset of a vertex slot, ~1e-7 of a grid cell. This keeps
+ * the cocircular points of a perfect lattice from leaving every incircle
+ * test at zero.
+ */
+static double jitter(int s, unsigned int salt){
+	unsigned int h = ((unsigned int) s*2654435761u) ^ salt;
+	h *= 2246822519u;
+	return 1e-7*((h >> 8)/16777216.0 - 0.5);
+}
+
+
+//######################################################################################################################
+//####################################    Ceiling Cat & Basement Cat     ###############################################
+//######################################################################################################################
+
+Delaunay::Delaunay() : keyed(false), stamp(0), last(0), retri(0){
+}
+
+//######################################################################################################################
+//####################################           Check stuff             ###############################################
+//######################################################################################################################
+
+/***
+ * Directions of the three super-vertices, counter-clockwise. A slot below 3
+ * sits at (px, py) + M*dir for an M taken to infinity, so no finite vortex
+ * set can reach past the super-triangle or see it in a circumcircle.
+ */
+static const double superDx[3] = {-2.0, 2.0, 0.0};
+static const double superDy[3] = {-1.0, -1.0, 2.0};
+
+/***
+ * Polynomials in M, lowest power first, for the predicates on super-vertices.
+ */
+struct Poly {
+	double c[5];
+};
+
+static Poly polyMul(const Poly &a, const Poly &b){
+	Poly r = {{0, 0, 0, 0, 0}};
+	for(int i = 0; i < 5; ++i)
+		for(int j = 0; i + j < 5; ++j)
+			r.c[i+j] += a.c[i]*b.c[j];
+	return r;
+}
+
+static Poly polySub(const Poly &a, const Poly &b){
+	Poly r;
+	for(int i = 0; i < 5; ++i)
+		r.c[i] = a.c[i] - b.c[i];
+	return r;
+}
+
+/***
+ * Sign of the polynomial as M goes to infinity, as the leading non-zero
+ * coefficient.
+ */
+static double polyLead(const Poly &a){
+	for(int i = 4; i >= 0; --i)
+		if(a.c[i] != 0.0)
+			return a.c[i];
+	return 0.0;
+}
+
+/***
+ * Coordinates of slot a relative to slot p.
+ */
+static void rel(const std::vector<double> &px, const std::vector<double> &py, int a, int p, Poly &x, Poly &y){
+	x.c[0] = px[a] - px[p];
+	y.c[0] = py[a] - py[p];
+	x.c[1] = ((a < 3) ? superDx[a] : 0.0) - ((p < 3) ? superDx[p] : 0.0);
+	y.c[1] = ((a < 3) ? superDy[a] : 0.0) - ((p < 3) ? superDy[p] : 0.0);
+	x.c[2] = x.c[3] = x.c[4] = y.c[2] = y.c[3] = y.c[4] = 0.0;
+}
+
+/***
+ * Positive if p lies to the left of a->b.
+ */
+double Delaunay::orient(int a, int b, int p){
+	if(a >= 3 && b >= 3 && p >= 3)
+		return (px[b] - px[a])*(py[p] - py[a]) - (py[b] - py[a])*(px[p] - px[a]);
+	Poly ax, ay, bx, by;
+	rel(px, py, a, p, ax, ay);
+	rel(px, py, b, p, bx, by);
+	return polyLead(polySub(polyMul(ax, by), polyMul(ay, bx)));
+}
+
+/***
+ * True if p lies inside the circumcircle of the counter-clockwise triangle abc.
+ */
+bool Delaunay::inCircle(int a, int b, int c, int p){
+	if(a >= 3 && b >= 3 && c >= 3 && p >= 3){
+		double adx = px[a] - px[p], ady = py[a] - py[p];
+		double bdx = px[b] - px[p], bdy = py[b] - py[p];
+		double cdx = px[c] - px[p], cdy = py[c] - py[p];
+		return (adx*adx + ady*ady)*(bdx*cdy - cdx*bdy)
+		     + (bdx*bdx + bdy*bdy)*(cdx*ady - adx*cdy)
+		     + (cdx*cdx + cdy*cdy)*(adx*bdy - bdx*ady) > 0.0;
+	}
+	Poly x[3], y[3], r[3];
+	int v[3] = {a, b, c};
+	for(int k = 0; k < 3; ++k){
+		rel(px, py, v[k], p, x[k], y[k]);
+		r[k] = polyMul(x[k], x[k]);
+		Poly yy = polyMul(y[k], y[k]);
+		for(int i = 0; i < 5; ++i)
+			r[k].c[i] += yy.c[i];
+	}
+	Poly det = {{0, 0, 0, 0, 0}};
+	for(int k = 0; k < 3; ++k){
+		int i = (k+1)%3, j = (k+2)%3;
+		Poly term = polyMul(r[k], polySub(polyMul(x[i], y[j]), polyMul(x[j], y[i])));
+		for(int m = 0; m < 5; ++m)
+			det.c[m] += term.c[m];
+	}
+	return polyLead(det) > 0.0;
+}
+
+bool Delaunay::inCircle(const Tri &t, int p){
+	return inCircle(t.v[0], t.v[1], t.v[2], p);
+}
+
+/***
+ * True if the triangles around p are still counter-clockwise and locally
+ * Delaunay against their neighbours. Only these can change when p moves.
+ */
+bool Delaunay::starValid(int p){
+	int t0 = vtri[p], t = t0;
+	for(int step = 0; step < 4096; ++step){
+		const Tri &f = tris[t];
+		int k = (f.v[0] == p) ? 0 : (f.v[1] == p) ? 1 : 2;
+		if(orient(f.v[0], f.v[1], f.v[2]) <= 0.0)
+			return false;
+		for(int e = 0; e < 3; ++e){
+			int nb = f.n[e];
+			if(nb < 0)
+				continue;
+			for(int j = 0; j < 3; ++j)
+				if(tris[nb].n[j] == t && inCircle(f, tris[nb].v[j]))
+					return false;
+		}
+		t = f.n[(k+1)%3];
+		if(t == t0)
+			return true;
+		if(t < 0)
+			return false;
+	}
+	return false;
+}
+
+/***
+ * True if (x,y) lies within the convex hull of the last extract(), found
+ * by bisecting the fan of hull vertices around the first.
+ */
+bool Delaunay::inHull(double x, double y){
+	int h = hullX.size();
+	if(h < 3)
+		return false;
+	auto cross = [&](int i, int j){
+		return (hullX[j] - hullX[i])*(y - hullY[i]) - (hullY[j] - hullY[i])*(x - hullX[i]);
+	};
+	if(cross(0, 1) < 0.0 || cross(0, h - 1) > 0.0)
+		return false;
+	int lo = 1, hi = h - 1;
+	while(hi - lo > 1){
+		int mid = (lo + hi)/2;
+		if(cross(0, mid) >= 0.0)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return cross(lo, hi) >= 0.0;
+}
+
+/***
+ * Walks from the last triangle made towards p, crossing any edge p lies
+ * beyond. The first edge tried rotates to avoid cycling; a full search is
+ * the fallback.
+ */
+int Delaunay::locate(int p){
+	int t = last;
+	if(t >= (int) tris.size() || tris[t].v[0] < 0){
+		for(t = 0; t < (int) tris.size() && tris[t].v[0] < 0; ++t);
+	}
+	for(int step = 0; step < 4*(int)tris.size() + 16; ++step){
+		int k = 0;
+		for(; k < 3; ++k){
+			int e = (k + step) % 3;
+			if(orient(tris[t].v[(e+1)%3], tris[t].v[(e+2)%3], p) < 0.0 && tris[t].n[e] >= 0){
+				t = tris[t].n[e];
+				break;
+			}
+		}
+		if(k == 3)
+			return t;
+	}
+	for(t = 0; t < (int) tris.size(); ++t){
+		if(tris[t].v[0] >= 0 && orient(tris[t].v[1], tris[t].v[2], p) >= 0.0
+		   && orient(tris[t].v[2], tris[t].v[0], p) >= 0.0 && orient(tris[t].v[0], tris[t].v[1], p) >= 0.0)
+			return t;
+	}
+	return last;
+}
+
+//######################################################################################################################
+//####################################              + stuff              ###############################################
+//######################################################################################################################
+
+int Delaunay::newTri(int a, int b, int c){
+	int t;
+	if(!freeTris.empty()){
+		t = freeTris.back();
+		freeTris.pop_back();
+	}
+	else{
+		t = tris.size();
+		tris.push_back(Tri());
+		mark.push_back(0);
+	}
+	Tri &f = tris[t];
+	f.v[0] = a; f.v[1] = b; f.v[2] = c;
+	f.n[0] = f.n[1] = f.n[2] = -1;
+	vtri[a] = vtri[b] = vtri[c] = t;
+	return t;
+}
+
+/***
+ * Points the side of triangle x holding edge b->a at triangle t.
+ */
+void Delaunay::link(int x, int a, int b, int t){
+	if(x < 0)
+		return;
+	for(int k = 0; k < 3; ++k)
+		if(tris[x].v[(k+1)%3] == b && tris[x].v[(k+2)%3] == a)
+			tris[x].n[k] = t;
+}
+
+int Delaunay::newSlot(const Vtx::Vortex &v, int idx){
+	int s;
+	if(!freeSlots.empty()){
+		s = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else{
+		s = px.size();
+		px.push_back(0); py.push_back(0);
+		vtri.push_back(-1); slotIdx.push_back(-1);
+		slotUid.push_back(0); slotLive.push_back(0);
+		fanA.push_back(-1); fanB.push_back(-1);
+	}
+	px[s] = v.coordsD.x + jitter(s, 0);
+	py[s] = v.coordsD.y + jitter(s, 0x9E3779B9u);
+	vtri[s] = -1;
+	slotIdx[s] = idx;
+	slotUid[s] = v.uid;
+	slotLive[s] = 1;
+	slotOfUid[v.uid] = s;
+	return s;
+}
+
+/***
+ * Bowyer-Watson step: removes the triangles whose circumcircles hold p and
+ * fans the hole from p. The hole is grown until p sees every boundary edge,
+ * so near-degenerate predicates cannot fold the fan over. A vortex on top
+ * of another is left out, and false returned.
+ */
+bool Delaunay::insert(int p){
+	int t = locate(p);
+	for(int k = 0; k < 3; ++k){
+		int v = tris[t].v[k];
+		if(v >= 3 && fabs(px[v] - px[p]) < 1e-6 && fabs(py[v] - py[p]) < 1e-6)
+			return false;
+	}
+	++stamp;
+	cavity.clear();
+	cavity.push_back(t);
+	mark[t] = stamp;
+	for(size_t i = 0; i < cavity.size(); ++i){
+		const Tri &c = tris[cavity[i]];
+		for(int k = 0; k < 3; ++k){
+			int nb = c.n[k];
+			if(nb >= 0 && mark[nb] != stamp && inCircle(tris[nb], p)){
+				mark[nb] = stamp;
+				cavity.push_back(nb);
+			}
+		}
+	}
+	for(bool grown = true; grown;){
+		grown = false;
+		for(size_t i = 0; i < cavity.size(); ++i){
+			const Tri &c = tris[cavity[i]];
+			for(int k = 0; k < 3; ++k){
+				int nb = c.n[k];
+				if(nb >= 0 && mark[nb] != stamp && orient(c.v[(k+1)%3], c.v[(k+2)%3], p) <= 0.0){
+					mark[nb] = stamp;
+					cavity.push_back(nb);
+					grown = true;
+				}
+			}
+		}
+	}
+
+	bndA.clear(); bndB.clear(); bndN.clear();
+	for(int c : cavity){
+		for(int k = 0; k < 3; ++k){
+			int nb = tris[c].n[k];
+			if(nb < 0 || mark[nb] != stamp){
+				bndA.push_back(tris[c].v[(k+1)%3]);
+				bndB.push_back(tris[c].v[(k+2)%3]);
+				bndN.push_back(nb);
+			}
+		}
+		tris[c].v[0] = -1;
+		freeTris.push_back(c);
+	}
+	for(size_t e = 0; e < bndA.size(); ++e){
+		int a = bndA[e], b = bndB[e];
+		int f = newTri(p, a, b);
+		tris[f].n[0] = bndN[e];
+		link(bndN[e], a, b, f);
+		fanA[a] = f;
+		fanB[b] = f;
+		last = f;
+	}
+	for(size_t e = 0; e < bndA.size(); ++e){
+		Tri &f = tris[fanA[bndA[e]]];
+		f.n[1] = fanA[bndB[e]]; //Across (b,p), the fan triangle starting at b
+		f.n[2] = fanB[bndA[e]]; //Across (p,a), the fan triangle ending at a
+	}
+	return true;
+}
+
+//######################################################################################################################
+//####################################              - stuff              ###############################################
+//######################################################################################################################
+
+/***
+ * Takes p out and fills the star-shaped hole by ear clipping, each time
+ * cutting an ear whose circumcircle holds no other hole vertex. Those ears
+ * are Delaunay, so the result is what a full rebuild would give. Returns
+ * false if rounding left no such ear; the caller then rebuilds.
+ */
+bool Delaunay::remove(int p){
+	if(vtri[p] < 0)
+		return true;
+	poly.clear();
+	polyN.clear();
+	cavity.clear();
+	int t0 = vtri[p], t = t0;
+	do{
+		const Tri &f = tris[t];
+		int k = (f.v[0] == p) ? 0 : (f.v[1] == p) ? 1 : 2;
+		poly.push_back(f.v[(k+1)%3]); //Hole edge poly[i] -> poly[i+1] ...
+		polyN.push_back(f.n[k]); //... and the triangle beyond it
+		cavity.push_back(t);
+		t = f.n[(k+1)%3];
+	} while(t != t0 && t >= 0 && cavity.size() < 4096);
+	if(t != t0)
+		return false;
+	for(int c : cavity){
+		tris[c].v[0] = -1;
+		freeTris.push_back(c);
+	}
+	vtri[p] = -1;
+
+	while(poly.size() > 3){
+		int m = poly.size(), ear = -1;
+		for(int i = 0; i < m && ear < 0; ++i){
+			int a = poly[(i+m-1)%m], b = poly[i], c = poly[(i+1)%m];
+			if(orient(a, b, c) <= 0.0)
+				continue;
+			ear = i;
+			for(int j = 0; j < m; ++j){
+				int q = poly[j];
+				if(q != a && q != b && q != c && inCircle(a, b, c, q)){
+					ear = -1;
+					break;
+				}
+			}
+		}
+		if(ear < 0)
+			return false;
+		int ip = (ear+m-1)%m, a = poly[ip], b = poly[ear], c = poly[(ear+1)%m];
+		int f = newTri(a, b, c);
+		tris[f].n[0] = polyN[ear];
+		tris[f].n[2] = polyN[ip];
+		link(polyN[ear], b, c, f);
+		link(polyN[ip], a, b, f);
+		polyN[ip] = f; //Edge a -> c is now held by f
+		poly.erase(poly.begin() + ear);
+		polyN.erase(polyN.begin() + ear);
+	}
+	int f = newTri(poly[0], poly[1], poly[2]);
+	tris[f].n[0] = polyN[1];
+	tris[f].n[1] = polyN[2];
+	tris[f].n[2] = polyN[0];
+	link(polyN[0], poly[0], poly[1], f);
+	link(polyN[1], poly[1], poly[2], f);
+	link(polyN[2], poly[2], poly[0], f);
+	last = f;
+	return true;
+}
+
+/***
+ * Moves p to (x,y). If its triangles stay valid only the position changes;
+ * otherwise it is taken out and put back.
+ */
+bool Delaunay::move(int p, double x, double y){
+	double ox = px[p], oy = py[p];
+	px[p] = x;
+	py[p] = y;
+	if(vtri[p] >= 0 && starValid(p))
+		return true;
+	++retri;
+	if(vtri[p] < 0){
+		insert(p);
+		return true;
+	}
+	px[p] = ox;
+	py[p] = oy;
+	if(!remove(p))
+		return false;
+	px[p] = x;
+	py[p] = y;
+	insert(p);
+	return true;
+}
+
+//######################################################################################################################
+//####################################            Build stuff            ###############################################
+//######################################################################################################################
+
+unsigned int Delaunay::triangulate(const Vtx::Vortex *v, unsigned int num){
+	int n = num;
+	double x0 = 0, x1 = 0, y0 = 0, y1 = 0;
+	for(int i = 0; i < n; ++i){
+		if(i == 0 || v[i].coordsD.x < x0) x0 = v[i].coordsD.x;
+		if(i == 0 || v[i].coordsD.x > x1) x1 = v[i].coordsD.x;
+		if(i == 0 || v[i].coordsD.y < y0) y0 = v[i].coordsD.y;
+		if(i == 0 || v[i].coordsD.y > y1) y1 = v[i].coordsD.y;
+	}
+	double D = std::max(x1 - x0, y1 - y0) + 1.0;
+
+	px.assign(3, 0.5*(x0 + x1)); //Super-vertices, at infinity along superDx/y
+	py.assign(3, 0.5*(y0 + y1));
+	vtri.assign(3, 0); slotIdx.assign(3, -1);
+	slotUid.assign(3, 0); slotLive.assign(3, 0);
+	fanA.assign(3, -1); fanB.assign(3, -1);
+	freeSlots.clear();
+	slotOfUid.clear();
+	slotOfUid.reserve(2*n);
+	keyed = true;
+	for(int i = 0; i < n; ++i){
+		if(slotOfUid.count(v[i].uid))
+			keyed = false;
+		newSlot(v[i], i);
+	}
+
+	tris.clear();
+	freeTris.clear();
+	mark.assign(1, 0);
+	Tri s = {{0, 1, 2}, {-1, -1, -1}};
+	tris.push_back(s);
+	tris.reserve(2*n + 8);
+	stamp = 0;
+	last = 0;
+
+	std::vector<unsigned int> key(n);
+	order.resize(n);
+	for(int i = 0; i < n; ++i){
+		key[i] = hilbertIdx((unsigned int)(65535*(px[i+3] - x0 + 0.5)/(D + 1.0)),
+		                    (unsigned int)(65535*(py[i+3] - y0 + 0.5)/(D + 1.0)));
+		order[i] = i + 3;
+	}
+	std::sort(order.begin(), order.end(), [&key](int a, int b){ return key[a-3] < key[b-3]; });
+	for(int i = 0; i < n; ++i)
+		insert(order[i]);
+	retri = num;
+	return extract(num);
+}
+
+unsigned int Delaunay::update(const Vtx::Vortex *v, unsigned int num){
+	if(!keyed || tris.empty())
+		return triangulate(v, num);
+	retri = 0;
+	for(size_t s = 3; s < slotIdx.size(); ++s)
+		slotIdx[s] = -1;
+	inSlot.resize(num);
+	for(unsigned int i = 0; i < num; ++i){
+		std::unordered_map<unsigned int, int>::iterator it = slotOfUid.find(v[i].uid);
+		inSlot[i] = (it == slotOfUid.end()) ? -1 : it->second;
+		if(inSlot[i] >= 0){
+			if(slotIdx[inSlot[i]] >= 0)
+				return triangulate(v, num); //Repeated UID
+			slotIdx[inSlot[i]] = i;
+		}
+	}
+	for(int s = 3; s < (int) slotIdx.size(); ++s){ //Deaths
+		if(slotLive[s] && slotIdx[s] < 0){
+			++retri;
+			if(!remove(s))
+				return triangulate(v, num);
+			slotLive[s] = 0;
+			slotOfUid.erase(slotUid[s]);
+			freeSlots.push_back(s);
+		}
+	}
+	for(unsigned int i = 0; i < num; ++i){ //Moves
+		int s = inSlot[i];
+		if(s < 0)
+			continue;
+		double x = v[i].coordsD.x + jitter(s, 0), y = v[i].coordsD.y + jitter(s, 0x9E3779B9u);
+		if((x != px[s] || y != py[s]) && !move(s, x, y))
+			return triangulate(v, num);
+	}
+	for(unsigned int i = 0; i < num; ++i){ //Births
+		if(inSlot[i] < 0){
+			++retri;
+			insert(newSlot(v[i], i));
+		}
+	}
+	return extract(num);
+}
+
+/***
+ * Lists each edge between two vortices once, by input index, and flags the
+ * vortices on the convex hull. Every hull vortex touches the super-triangle,
+ * so only those are passed to the monotone chain. Vortices within 1e-4 of
+ * a hull edge also count as on it, as jitter would otherwise decide. Those
+ * sit in slivers along the hull rather than touching the super-triangle,
+ * so the corners of flat triangles are checked too.
+ */
+unsigned int Delaunay::extract(unsigned int num){
+	edgeA.clear();
+	edgeB.clear();
+	hull.assign(num, 0);
+	poly.clear();
+	++stamp;
+	for(int t = 0; t < (int) tris.size(); ++t){
+		const Tri &f = tris[t];
+		if(f.v[0] < 0)
+			continue;
+		bool super = f.v[0] < 3 || f.v[1] < 3 || f.v[2] < 3;
+		if(!super){
+			double o = orient(f.v[0], f.v[1], f.v[2]), len = 0.0;
+			for(int k = 0; k < 3; ++k){
+				int a = f.v[(k+1)%3], b = f.v[(k+2)%3];
+				len = std::max(len, (px[b] - px[a])*(px[b] - px[a]) + (py[b] - py[a])*(py[b] - py[a]));
+			}
+			super = o*o < 1e-8*len; //Sliver along the hull
+		}
+		for(int k = 0; k < 3; ++k){
+			int a = f.v[(k+1)%3], b = f.v[(k+2)%3];
+			if(super && f.v[k] >= 3 && fanA[f.v[k]] != -stamp){
+				fanA[f.v[k]] = -stamp;
+				poly.push_back(f.v[k]);
+			}
+			if(a < 3 || b < 3 || (f.n[k] >= 0 && f.n[k] < t))
+				continue;
+			edgeA.push_back(std::min(slotIdx[a], slotIdx[b]));
+			edgeB.push_back(std::max(slotIdx[a], slotIdx[b]));
+		}
+	}
+	std::sort(poly.begin(), poly.end(), [this](int a, int b){
+		return px[a] < px[b] || (px[a] == px[b] && py[a] < py[b]);
+	});
+	polyN.clear();
+	for(int pass = 0; pass < 2; ++pass){ //Lower, then upper chain
+		size_t base = polyN.size();
+		for(int i = 0; i < (int) poly.size(); ++i){
+			int c = pass ? poly[poly.size() - 1 - i] : poly[i];
+			while(polyN.size() >= base + 2 && orient(polyN[polyN.size() - 2], c, polyN.back()) >= 0.0)
+				polyN.pop_back();
+			polyN.push_back(c);
+		}
+		if(!polyN.empty() && poly.size() > 1)
+			polyN.pop_back(); //First point of the other chain
+	}
+	hullX.resize(polyN.size());
+	hullY.resize(polyN.size());
+	for(size_t i = 0; i < polyN.size(); ++i){
+		hullX[i] = px[polyN[i]];
+		hullY[i] = py[polyN[i]];
+	}
+	for(size_t i = 0; i < polyN.size(); ++i){
+		int a = polyN[i], b = polyN[(i+1)%polyN.size()];
+		double len = sqrt((px[b] - px[a])*(px[b] - px[a]) + (py[b] - py[a])*(py[b] - py[a]));
+		hull[slotIdx[a]] = 1;
+		for(int c : poly){
+			double u = (px[c] - px[a])*(px[b] - px[a]) + (py[c] - py[a])*(py[b] - py[a]);
+			if(c != a && c != b && u > 0.0 && u < len*len && fabs(orient(a, b, c)) < 1e-4*len){
+				hull[slotIdx[c]] = 1;
+			}
+		}
+	}
+	for(size_t s = 3; s < slotIdx.size(); ++s)
+		if(slotLive[s] && vtri[s] < 0) //Coincident vortex; left out
+			hull[slotIdx[s]] = 1;
+	return edgeA.size();
+}
+
+/***
+ * Shoelace sum over the circumcentres of the triangles around each vortex,
+ * taken counter-clockwise and relative to the vortex to keep precision.
+ * Cells touching the hull, or with a corner outside it, are left open too,
+ * since the thin triangles there put circumcentres far outside the lattice.
+ */
+void Delaunay::voronoi(double *area, unsigned int *sides){
+	int num = hull.size();
+	for(int i = 0; i < num; ++i){
+		area[i] = 0.0;
+		sides[i] = 0;
+	}
+	#pragma omp parallel for schedule(dynamic,256)
+	for(int s = 3; s < (int) slotIdx.size(); ++s){
+		if(!slotLive[s] || vtri[s] < 0 || hull[slotIdx[s]])
+			continue;
+		double sum = 0.0, fx = 0.0, fy = 0.0, lx = 0.0, ly = 0.0;
+		unsigned int k = 0;
+		int t0 = vtri[s], t = t0;
+		do{
+			const Tri &f = tris[t];
+			int j = (f.v[0] == s) ? 0 : (f.v[1] == s) ? 1 : 2;
+			int a = f.v[(j+1)%3], b = f.v[(j+2)%3];
+			if(a < 3 || b < 3 || hull[slotIdx[a]]){ //Open, or stretched by the flat triangles at the hull
+				k = 0;
+				break;
+			}
+			double ax = px[a] - px[s], ay = py[a] - py[s], bx = px[b] - px[s], by = py[b] - py[s];
+			double d = 2.0*(ax*by - ay*bx), a2 = ax*ax + ay*ay, b2 = bx*bx + by*by;
+			double cx = (by*a2 - ay*b2)/d, cy = (ax*b2 - bx*a2)/d;
+			if(!inHull(px[s] + cx, py[s] + cy)){
+				k = 0;
+				break;
+			}
+			if(k == 0){
+				fx = cx;
+				fy = cy;
+			}
+			else
+				sum += lx*cy - cx*ly;
+			lx = cx;
+			ly = cy;
+			++k;
+			t = f.n[(j+1)%3];
+		} while(t != t0 && t >= 0 && k < 4096);
+		if(k < 3 || t != t0)
+			continue;
+		sum += lx*fy - fx*ly;
+		area[slotIdx[s]] = 0.5*sum;
+		sides[slotIdx[s]] = k;
+	}
+}
+
+//######################################################################################################################
+//####################################            Get stuff              ###############################################
+//######################################################################################################################
+
+unsigned int Delaunay::getNumRetriangulated(){
+	return retri;
+}
+
+const std::vector<unsigned int> &Delaunay::getEdgeA(){
+	return edgeA;
+}
+
+const std::vector<unsigned int> &Delaunay::getEdgeB(){
+	return edgeB;
+}
+
+const std::vector<char> &Delaunay::getHull(){
+	return hull;
+}
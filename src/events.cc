@@ -0,0 +1,190 @@
+/*** events.cc - GPUE: Split Operator based GPU solver for Nonlinear
+Schrodinger Equation, Copyright (C) 2011-2015, Lee J. O'Riordan
+<loriordan@gmail.com>, Tadhg Morgan, Neil Crowley.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <math.h>
+#include <unordered_map>
+#include "../include/events.h"
+#include "../include/fileIO.h"
+
+namespace Events {
+
+	Engine::Engine() : log(NULL), window(0), steps(1), jump(0.0), pairDist(0.0), primed(false), windowEnd(-1), ringHead(0), ringCount(0){
+	}
+
+	Engine::~Engine(){
+		close();
+	}
+
+	int Engine::open(char *file, int window, int steps, double jump, double pairDist, int fromStep){
+		log = FileIO::openSeries(file, fromStep);
+		if(log == NULL){
+			fprintf(stderr,"Cannot open %s\n",file);
+			return -1;
+		}
+		if(ftell(log) == 0)
+			fprintf(log, "#STEP,TYPE,UID,X,Y,DATA\n");
+		this->window = (window < 1) ? 1 : window;
+		this->steps = (steps < 1) ? 1 : steps;
+		this->jump = jump;
+		this->pairDist = pairDist;
+		primed = false;
+		windowEnd = -1;
+		ringStep.assign(this->window, 0);
+		ringHead = 0;
+		ringCount = 0;
+		return 0;
+	}
+
+	bool Engine::isOpen(){
+		return log != NULL;
+	}
+
+	void Engine::logEvent(int step, const char *type, long uid, double x, double y, double data){
+		fprintf(log, "%d,%s,%ld,%e,%e,%e\n", step, type, uid, x, y, data);
+	}
+
+	/*
+	 * Births and deaths are the UIDs found in only one of the two samples.
+	 * Those of opposite winding within pairDist of each other are reported
+	 * as one creation or annihilation, pairing greedily by distance.
+	 */
+	int Engine::observe(const Vtx::Vortex *prev, int numPrev, const Vtx::Vortex *cur, int num, int step){
+		if(log == NULL)
+			return 0;
+		if(!primed){
+			primed = true;
+			if(numPrev == 0)
+				return 0;
+		}
+		int mask = 0;
+		std::unordered_map<unsigned int, int> prevOfUid(2*numPrev);
+		for(int k = 0; k < numPrev; ++k)
+			prevOfUid[prev[k].uid] = k;
+		std::vector<char> kept(numPrev, 0);
+		std::vector<const Vtx::Vortex*> born, died;
+		for(int k = 0; k < num; ++k){
+			std::unordered_map<unsigned int, int>::iterator it = prevOfUid.find(cur[k].uid);
+			if(it == prevOfUid.end()){
+				born.push_back(&cur[k]);
+				continue;
+			}
+			kept[it->second] = 1;
+			const Vtx::Vortex &p = prev[it->second];
+			double d = hypot(cur[k].coordsD.x - p.coordsD.x, cur[k].coordsD.y - p.coordsD.y);
+			if(jump > 0.0 && d > jump){
+				logEvent(step, "jump", cur[k].uid, cur[k].coordsD.x, cur[k].coordsD.y, d);
+				mask |= EV_JUMP;
+			}
+		}
+		for(int k = 0; k < numPrev; ++k)
+			if(!kept[k])
+				died.push_back(&prev[k]);
+
+		for(int pass = 0; pass < 2; ++pass){
+			std::vector<const Vtx::Vortex*> &v = (pass == 0) ? died : born;
+			std::vector<char> paired(v.size(), 0);
+			for(size_t a = 0; a < v.size(); ++a){
+				if(paired[a])
+					continue;
+				int best = -1;
+				double bestD = pairDist;
+				for(size_t b = a + 1; b < v.size(); ++b){
+					if(paired[b] || v[b]->wind != -v[a]->wind)
+						continue;
+					double d = hypot(v[a]->coordsD.x - v[b]->coordsD.x, v[a]->coordsD.y - v[b]->coordsD.y);
+					if(d <= bestD){
+						bestD = d;
+						best = b;
+					}
+				}
+				if(best >= 0){
+					paired[a] = paired[best] = 1;
+					logEvent(step, (pass == 0) ? "annihilation" : "creation", v[a]->uid,
+					         0.5*(v[a]->coordsD.x + v[best]->coordsD.x), 0.5*(v[a]->coordsD.y + v[best]->coordsD.y), v[best]->uid);
+					mask |= (pass == 0) ? EV_ANNIHILATION : EV_CREATION;
+				}
+			}
+			for(size_t a = 0; a < v.size(); ++a){
+				if(paired[a])
+					continue;
+				logEvent(step, (pass == 0) ? "death" : "birth", v[a]->uid, v[a]->coordsD.x, v[a]->coordsD.y, v[a]->wind);
+				mask |= (pass == 0) ? EV_DEATH : EV_BIRTH;
+			}
+		}
+		if(num != numPrev){
+			logEvent(step, "count", -1, 0.0, 0.0, num);
+			mask |= EV_COUNT;
+		}
+		if(mask != 0){
+			windowEnd = step + window*steps;
+			fflush(log);
+		}
+		return mask;
+	}
+
+	bool Engine::inWindow(int step){
+		return step <= windowEnd;
+	}
+
+	bool Engine::sampleDue(int step){
+		return log != NULL && inWindow(step) && step % steps == 0;
+	}
+
+	int Engine::push(int step){
+		int slot = (ringHead + ringCount) % window;
+		if(ringCount < window)
+			++ringCount;
+		else
+			ringHead = (ringHead + 1) % window;
+		ringStep[slot] = step;
+		return slot;
+	}
+
+	int Engine::drain(int *slot, int *step){
+		for(int k = 0; k < ringCount; ++k){
+			slot[k] = (ringHead + k) % window;
+			step[k] = ringStep[slot[k]];
+		}
+		int n = ringCount;
+		ringHead = 0;
+		ringCount = 0;
+		return n;
+	}
+
+	void Engine::close(){
+		if(log != NULL)
+			fclose(log);
+		log = NULL;
+	}
+}
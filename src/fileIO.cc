@@ -34,11 +34,62 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <cuda_runtime.h>
+#include <vector>
+#include <set>
+#include <string>
+#ifdef _OPENMP
+	#include <omp.h>
+#endif
 #include "../include/fileIO.h"
 
 namespace FileIO{
 
+	static std::set<std::string> series; //Text series this process has written to
+
+	/*
+	 * Formats items [0,length) as text in parallel and writes them to f in
+	 * order. fmt(i, out) prints item i into out (at most maxLen bytes) and
+	 * returns the number of characters written. Each thread formats one
+	 * contiguous block per round into its own buffer; the blocks are then
+	 * written sequentially, so the file is identical to a serial loop.
+	 */
+	template <typename Fmt>
+	static void writeBlocks(FILE *f, int length, int maxLen, Fmt fmt){
+		int threads = 1;
+		#ifdef _OPENMP
+		threads = omp_get_max_threads();
+		#endif
+		int chunk = (1<<20)/maxLen;
+		if (chunk < 1)
+			chunk = 1;
+		if (threads > 1 && length < 2*chunk)
+			threads = 1;
+		std::vector< std::vector<char> > buf(threads, std::vector<char>((size_t) chunk*maxLen + 1));
+		std::vector<size_t> used(threads);
+
+		for (int start = 0; start < length; start += threads*chunk){
+			#pragma omp parallel for num_threads(threads) schedule(static,1)
+			for (int t = 0; t < threads; ++t){
+				int i0 = start + t*chunk;
+				int i1 = i0 + chunk < length ? i0 + chunk : length;
+				char *out = &buf[t][0];
+				size_t n = 0;
+				for (int i = i0; i < i1; ++i)
+					n += fmt(i, out + n);
+				used[t] = n;
+			}
+			for (int t = 0; t < threads; ++t)
+				if (used[t] > 0)
+					fwrite(&buf[t][0], 1, used[t], f);
+		}
+	}
+
 	/*
 	 * Reads datafile into memory.
 	 */
@@ -48,21 +99,71 @@ namespace FileIO{
 		int i = 0;
 		double2 *arr = (double2*) malloc(sizeof(double2)*xDim*yDim);
 		double line;
-		while(fscanf(f,"%lE",&line) > 0){
+		while(i < xDim*yDim && fscanf(f,"%lE",&line) > 0){
 			arr[i].x = line;
 			++i;
 		}
 		fclose(f);
+		if(i != xDim*yDim)
+			fprintf(stderr,"Warning: read %d of %d values from %s\n",i,xDim*yDim,fileR);
 		f = fopen(fileI,"r");
 		i = 0;
-		while(fscanf(f,"%lE",&line) > 0){
+		while(i < xDim*yDim && fscanf(f,"%lE",&line) > 0){
 			arr[i].y = line;
 			++i;
 		}
 		fclose(f);
+		if(i != xDim*yDim)
+			fprintf(stderr,"Warning: read %d of %d values from %s\n",i,xDim*yDim,fileI);
 		return arr;
 	}
 
+	/*
+	 * Maps a binary snapshot into memory and copies the payload into dest.
+	 * No parsing; the page cache is read once, sequentially.
+	 */
+	double2* readInBin(char* file, double2 *dest, int xDim, int yDim){
+		int fd = open(file, O_RDONLY);
+		if(fd < 0){
+			fprintf(stderr,"Cannot open %s\n",file);
+			return NULL;
+		}
+		struct stat st;
+		if(fstat(fd,&st) != 0 || (size_t) st.st_size < sizeof(SnapHeader)){
+			fprintf(stderr,"%s is too small to be a snapshot\n",file);
+			close(fd);
+			return NULL;
+		}
+		void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if(map == MAP_FAILED){
+			fprintf(stderr,"Cannot map %s\n",file);
+			return NULL;
+		}
+		madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+		SnapHeader h;
+		memcpy(&h, map, sizeof(SnapHeader));
+		unsigned long long len = (unsigned long long) xDim*yDim;
+		if(strncmp(h.magic,"GPUE",4) != 0 || h.version != 1 || h.elemSize != sizeof(double2)){
+			fprintf(stderr,"%s is not a GPUE double2 snapshot\n",file);
+			dest = NULL;
+		}
+		else if(h.xDim != xDim || h.yDim != yDim || h.count != len){
+			fprintf(stderr,"%s holds a %dx%d grid, expected %dx%d\n",file,h.xDim,h.yDim,xDim,yDim);
+			dest = NULL;
+		}
+		else if((size_t) st.st_size < sizeof(SnapHeader) + len*sizeof(double2)){
+			fprintf(stderr,"%s is truncated\n",file);
+			dest = NULL;
+		}
+		else{
+			memcpy(dest, (char*) map + sizeof(SnapHeader), len*sizeof(double2));
+		}
+		munmap(map, st.st_size);
+		return dest;
+	}
+
 	/*
 	 * Writes out the parameter file.
 	 */
@@ -78,6 +179,138 @@ namespace FileIO{
 		fclose(f);
 	}
 
+	/*
+	 * Reads the per-dataset output policies and resolves each region against
+	 * the grid.
+	 */
+	int readOutPolicies(char *file, OutPolicy *pol, int maxPol, int xDim, int yDim){
+		FILE *f;
+		char line[256], mode[16];
+		int n = 0;
+		f = fopen(file,"r");
+		if(f == NULL){
+			fprintf(stderr,"Cannot open output policy file %s\n",file);
+			return -1;
+		}
+		while(n < maxPol && fgets(line, sizeof(line), f) != NULL){
+			OutPolicy p;
+			memset(&p, 0, sizeof(OutPolicy));
+			if(line[0] == '#' || sscanf(line, "%31s %15s", p.name, mode) != 2)
+				continue;
+			p.stride = 1;
+			p.nx = xDim; p.ny = yDim;
+			if(strcmp(mode,"crop") == 0){
+				p.mode = OUT_CROP;
+				sscanf(line, "%*s %*s %d %d %d %d", &p.x0, &p.y0, &p.nx, &p.ny);
+			}
+			else if(strcmp(mode,"radius") == 0){
+				p.mode = OUT_RADIUS;
+				p.cx = xDim/2; p.cy = yDim/2;
+				sscanf(line, "%*s %*s %lf %d %d", &p.radius, &p.cx, &p.cy);
+				int r = (int) ceil(p.radius);
+				p.x0 = p.cx - r; p.y0 = p.cy - r;
+				p.nx = 2*r + 1; p.ny = 2*r + 1;
+			}
+			else if(strcmp(mode,"stride") == 0){
+				p.mode = OUT_STRIDE;
+				sscanf(line, "%*s %*s %d", &p.stride);
+				if(p.stride < 1)
+					p.stride = 1;
+				p.nx = (xDim + p.stride - 1)/p.stride;
+				p.ny = (yDim + p.stride - 1)/p.stride;
+			}
+			else if(strcmp(mode,"spectral") == 0){
+				p.mode = OUT_SPECTRAL;
+				sscanf(line, "%*s %*s %d %d", &p.nx, &p.ny);
+				p.nx = (p.nx < 2 || p.nx > xDim) ? xDim : p.nx & ~1;
+				p.ny = (p.ny < 2 || p.ny > yDim) ? yDim : p.ny & ~1;
+			}
+			else{
+				fprintf(stderr,"Unknown output mode %s for %s\n",mode,p.name);
+				continue;
+			}
+			if(p.mode == OUT_CROP || p.mode == OUT_RADIUS){ //Clip the region to the grid
+				if(p.x0 < 0){ p.nx += p.x0; p.x0 = 0; }
+				if(p.y0 < 0){ p.ny += p.y0; p.y0 = 0; }
+				if(p.x0 + p.nx > xDim) p.nx = xDim - p.x0;
+				if(p.y0 + p.ny > yDim) p.ny = yDim - p.y0;
+				if(p.nx < 1 || p.ny < 1){
+					fprintf(stderr,"Output region for %s lies outside the grid\n",p.name);
+					continue;
+				}
+			}
+			pol[n++] = p;
+		}
+		int extra = 0;
+		while(fgets(line, sizeof(line), f) != NULL){ //Policies past the cap are dropped, so say so
+			char name[32];
+			if(line[0] != '#' && sscanf(line, "%31s %15s", name, mode) == 2)
+				++extra;
+		}
+		if(extra > 0)
+			fprintf(stderr,"Only the first %d output policies in %s are used; %d more ignored\n",maxPol,file,extra);
+		fclose(f);
+		return n;
+	}
+
+	OutPolicy *findOutPolicy(char *name, OutPolicy *pol, int numPol){
+		for(int i = 0; i < numPol; ++i){
+			if(strcmp(pol[i].name, name) == 0)
+				return &pol[i];
+		}
+		return NULL;
+	}
+
+	/*
+	 * Gathers the kept region row by row. Points outside the disk of a radius
+	 * policy are zeroed so the output stays a rectangular grid.
+	 */
+	double2 *applyOutPolicy(OutPolicy &p, double2 *data, int xDim, int yDim, double2 *out){
+		int i, j;
+		double r2 = p.radius*p.radius;
+		for(i = 0; i < p.nx; ++i){
+			int si = p.x0 + i*p.stride;
+			for(j = 0; j < p.ny; ++j){
+				int sj = p.y0 + j*p.stride;
+				out[i*p.ny + j] = data[si*yDim + sj];
+				if(p.mode == OUT_RADIUS && (si-p.cx)*(si-p.cx) + (sj-p.cy)*(sj-p.cy) > r2){
+					out[i*p.ny + j].x = 0.0;
+					out[i*p.ny + j].y = 0.0;
+				}
+			}
+		}
+		return out;
+	}
+
+	/*
+	 * Writes the coordinates of the reduced grid so the analysis scripts can
+	 * place each sample: x = xStart + i*dx, y = yStart + j*dy.
+	 */
+	void writeOutMeta(char *buffer, char *file, OutPolicy &p, double *x, double *y, int xDim, int yDim){
+		FILE *f;
+		double dxOut = (x[1] - x[0])*p.stride;
+		double dyOut = (y[1] - y[0])*p.stride;
+		if(p.mode == OUT_SPECTRAL){
+			dxOut = (x[1] - x[0])*xDim/p.nx;
+			dyOut = (y[1] - y[0])*yDim/p.ny;
+		}
+		sprintf (buffer, "%s_meta", file);
+		f = fopen (buffer,"w");
+		fprintf (f, "[Output]\n");
+		fprintf (f, "mode=%d\n", p.mode);
+		fprintf (f, "nx=%d\n", p.nx);
+		fprintf (f, "ny=%d\n", p.ny);
+		fprintf (f, "x0=%d\n", p.x0);
+		fprintf (f, "y0=%d\n", p.y0);
+		fprintf (f, "stride=%d\n", p.stride);
+		fprintf (f, "radius=%e\n", p.radius);
+		fprintf (f, "dx=%e\n", dxOut);
+		fprintf (f, "dy=%e\n", dyOut);
+		fprintf (f, "xStart=%e\n", x[p.x0]);
+		fprintf (f, "yStart=%e\n", y[p.y0]);
+		fclose (f);
+	}
+
 	/*
 	 * Writes out double2 complex data files.
 	 */
@@ -85,28 +318,141 @@ namespace FileIO{
 		FILE *f;
 		sprintf (buffer, "%s_%d", file, step);
 		f = fopen (buffer,"w");
-		int i;
-		for (i = 0; i < length; i++)
-			fprintf (f, "%.16e\n",data[i].x);
+		writeBlocks(f, length, 32, [&](int i, char *out){
+			return snprintf(out, 32, "%.16e\n", data[i].x);
+		});
 		fclose (f);
 
 		sprintf (buffer, "%si_%d", file, step);
 		f = fopen (buffer,"w");
-		for (i = 0; i < length; i++)
-			fprintf (f, "%.16e\n",data[i].y);
+		writeBlocks(f, length, 32, [&](int i, char *out){
+			return snprintf(out, 32, "%.16e\n", data[i].y);
+		});
+		fclose (f);
+	}
+
+	/*
+	 * Writes out double2 complex data as a single binary snapshot.
+	 */
+	void writeOutBin(char* buffer, char *file, double2 *data, int xDim, int yDim, int step){
+		FILE *f;
+		SnapHeader h;
+		memcpy(h.magic,"GPUE",4);
+		h.version = 1;
+		h.xDim = xDim;
+		h.yDim = yDim;
+		h.step = step;
+		h.elemSize = sizeof(double2);
+		h.count = (unsigned long long) xDim*yDim;
+		sprintf (buffer, "%s_%d.bin", file, step);
+		f = fopen (buffer,"wb");
+		fwrite (&h, sizeof(SnapHeader), 1, f);
+		fwrite (data, sizeof(double2), h.count, f);
 		fclose (f);
 	}
 
+	/*
+	 * Writes the checkpoint to file.tmp first and renames it over file, so a
+	 * job killed mid-write still leaves the previous checkpoint intact.
+	 */
+	int writeCheckpoint(char *file, Checkpoint &chk, double2 *wfc, int xDim, int yDim, struct Vtx::Vortex *vortCoordsP, double2 *EV_opt, Array &arr, Vtx::VtxList &vortices, double *skMoments){
+		char tmp[256];
+		SnapHeader h;
+		memcpy(h.magic,"GPUC",4);
+		h.version = 5;
+		h.xDim = xDim;
+		h.yDim = yDim;
+		h.step = chk.step;
+		h.elemSize = sizeof(double2);
+		h.count = (unsigned long long) xDim*yDim;
+		sprintf (tmp, "%s.tmp", file);
+		FILE *f = fopen (tmp,"wb");
+		if(f == NULL){
+			fprintf(stderr,"Cannot write checkpoint %s\n",tmp);
+			return -1;
+		}
+		fwrite (&h, sizeof(SnapHeader), 1, f);
+		fwrite (&chk, sizeof(Checkpoint), 1, f);
+		fwrite (wfc, sizeof(double2), h.count, f);
+		if(chk.vortCap > 0)
+			fwrite (vortCoordsP, sizeof(struct Vtx::Vortex), chk.vortCap, f);
+		if(chk.hasOpt)
+			fwrite (EV_opt, sizeof(double2), h.count, f);
+		fwrite (&arr.used, sizeof(size_t), 1, f);
+		fwrite (arr.array, sizeof(Param), arr.used, f);
+		vortices.write(f);
+		if(chk.skSamples > 0)
+			fwrite (skMoments, sizeof(double), 2*xDim*(yDim/2 + 1), f);
+		if(fclose (f) != 0 || rename(tmp, file) != 0){
+			fprintf(stderr,"Cannot write checkpoint %s\n",file);
+			return -1;
+		}
+		return 0;
+	}
+
+	/*
+	 * Reads back everything writeCheckpoint stored, in the same order.
+	 */
+	int readCheckpoint(char *file, Checkpoint &chk, double2 *wfc, int xDim, int yDim, struct Vtx::Vortex **vortCoordsP, double2 *EV_opt, Array *arr, Vtx::VtxList *vortices, double **skMoments){
+		FILE *f = fopen (file,"rb");
+		if(f == NULL){
+			fprintf(stderr,"Cannot open checkpoint %s\n",file);
+			return -1;
+		}
+		SnapHeader h;
+		unsigned long long len = (unsigned long long) xDim*yDim;
+		if(fread (&h, sizeof(SnapHeader), 1, f) != 1 || strncmp(h.magic,"GPUC",4) != 0 || h.version != 5){
+			fprintf(stderr,"%s is not a GPUE checkpoint\n",file);
+			fclose(f);
+			return -1;
+		}
+		if(h.xDim != xDim || h.yDim != yDim || h.count != len){
+			fprintf(stderr,"%s holds a %dx%d grid, expected %dx%d\n",file,h.xDim,h.yDim,xDim,yDim);
+			fclose(f);
+			return -1;
+		}
+		int ok = fread (&chk, sizeof(Checkpoint), 1, f) == 1;
+		ok = ok && fread (wfc, sizeof(double2), len, f) == len;
+		*vortCoordsP = NULL;
+		if(ok && chk.vortCap > 0){
+			*vortCoordsP = (struct Vtx::Vortex*) malloc(sizeof(struct Vtx::Vortex)*chk.vortCap);
+			ok = fread (*vortCoordsP, sizeof(struct Vtx::Vortex), chk.vortCap, f) == (size_t) chk.vortCap;
+		}
+		if(ok && chk.hasOpt)
+			ok = fread (EV_opt, sizeof(double2), len, f) == len;
+		size_t used = 0;
+		ok = ok && fread (&used, sizeof(size_t), 1, f) == 1;
+		if(ok){
+			freeArray(arr);
+			initArr(arr, used > 0 ? used : 1);
+			ok = fread (arr->array, sizeof(Param), used, f) == used;
+			arr->used = used;
+		}
+		ok = ok && vortices->read(f) == 0;
+		*skMoments = NULL;
+		if(ok && chk.skSamples > 0){
+			size_t skLen = 2*(size_t) xDim*(yDim/2 + 1);
+			*skMoments = (double*) malloc(sizeof(double)*skLen);
+			ok = fread (*skMoments, sizeof(double), skLen, f) == skLen;
+		}
+		fclose(f);
+		if(!ok){
+			fprintf(stderr,"Checkpoint %s is truncated\n",file);
+			return -1;
+		}
+		return 0;
+	}
+
 	/*
 	 * Writes out double type data files.
 	 */
-	void writeOutDouble(char* buffer, char *file, double *data, int length, int step){
+	void writeOutDouble(char* buffer, const char *file, double *data, int length, int step){
 		FILE *f;
 		sprintf (buffer, "%s_%d", file, step);
 		f = fopen (buffer,"w");
-		int i;
-		for (i = 0; i < length; i++)
-			fprintf (f, "%.16e\n",data[i]);
+		writeBlocks(f, length, 32, [&](int i, char *out){
+			return snprintf(out, 32, "%.16e\n", data[i]);
+		});
 		fclose (f);
 	}
 
@@ -143,10 +489,198 @@ namespace FileIO{
 		FILE *f;
 		sprintf (buffer, "%s_%d", file, step);
 		f = fopen (buffer,"w");
-		int i;
 		fprintf (f, "#X,Y,WINDING\n");
-		for (i = 0; i < length; i++)
-			fprintf (f, "%d,%e,%d,%e,%d\n",data[i].coords.x,data[i].coordsD.x,data[i].coords.y,data[i].coordsD.y,data[i].wind);
+		writeBlocks(f, length, 96, [&](int i, char *out){
+			return snprintf(out, 96, "%d,%e,%d,%e,%d\n",data[i].coords.x,data[i].coordsD.x,data[i].coords.y,data[i].coordsD.y,data[i].wind);
+		});
+		fclose (f);
+	}
+
+	/*
+	 * Writes out tracked vortex data with UIDs.
+	 */
+	void writeOutVortexUid(char* buffer, char *file, struct Vtx::Vortex *data, int length, int step){
+		FILE *f;
+		sprintf (buffer, "%s_%d", file, step);
+		f = fopen (buffer,"w");
+		fprintf (f, "#X,Y,WINDING,UID\n");
+		writeBlocks(f, length, 112, [&](int i, char *out){
+			return snprintf(out, 112, "%d,%e,%d,%e,%d,%u\n",data[i].coords.x,data[i].coordsD.x,data[i].coords.y,data[i].coordsD.y,data[i].wind,data[i].uid);
+		});
+		fclose (f);
+	}
+
+	/*
+	 * Writes out the lifetime of every recorded vortex.
+	 */
+	void writeOutVortexLife(char* buffer, char *file, Vtx::VtxList &vortices){
+		FILE *f;
+		sprintf (buffer, "%s", file);
+		f = fopen (buffer,"w");
+		fprintf (f, "#UID,WINDING,BIRTH,DEATH\n");
+		for (int i = 0; i < vortices.size(); i++){
+			struct Vtx::Vortex v = vortices.get_Idx(i);
+			fprintf (f, "%u,%d,%d,%d\n",v.uid,v.wind,vortices.getBirth(i),vortices.getDeath(i));
+		}
+		fclose (f);
+	}
+
+	/*
+	 * Writes out the coordination of each vortex in the lattice graph.
+	 */
+	void writeOutCoordination(char* buffer, char *file, struct Vtx::Vortex *data, unsigned int *coord, char *hull, int length, int step){
+		FILE *f;
+		sprintf (buffer, "%s_%d", file, step);
+		f = fopen (buffer,"w");
+		fprintf (f, "#UID,X,Y,COORDINATION,HULL\n");
+		writeBlocks(f, length, 80, [&](int i, char *out){
+			return snprintf(out, 80, "%u,%e,%e,%u,%d\n",data[i].uid,data[i].coordsD.x,data[i].coordsD.y,coord[i],hull[i] != 0);
+		});
+		fclose (f);
+	}
+
+	/*
+	 * Writes out the orientational order and Voronoi cell of each vortex.
+	 */
+	void writeOutOrder(char* buffer, const char *file, struct Vtx::Vortex *data, double2 *psi, double *area, unsigned int *sides, int length, int step){
+		FILE *f;
+		sprintf (buffer, "%s_%d", file, step);
+		f = fopen (buffer,"w");
+		fprintf (f, "#UID,X,Y,PSI6_RE,PSI6_IM,AREA,SIDES\n");
+		writeBlocks(f, length, 112, [&](int i, char *out){
+			return snprintf(out, 112, "%u,%e,%e,%e,%e,%e,%u\n",data[i].uid,data[i].coordsD.x,data[i].coordsD.y,psi[i].x,psi[i].y,area[i],sides[i]);
+		});
+		fclose (f);
+	}
+
+	void writeOutG6(char* buffer, const char *file, double rMax, int bins, double *g6, double *pairs, int step){
+		FILE *f;
+		sprintf (buffer, "%s_%d", file, step);
+		f = fopen (buffer,"w");
+		fprintf (f, "#R,G6,PAIRS\n");
+		for (int b = 0; b < bins; b++)
+			fprintf (f, "%e,%e,%.0f\n", (b + 0.5)*rMax/bins, g6[b], pairs[b]);
+		fclose (f);
+	}
+
+	/*
+	 * Reads back "X,XD,Y,YD,WINDING,UID" rows, skipping the header.
+	 */
+	struct Vtx::Vortex *readVortexUid(char *file, int *length){
+		FILE *f = fopen(file,"r");
+		*length = 0;
+		if (f == NULL)
+			return NULL;
+		int cap = 1024;
+		struct Vtx::Vortex *v = (struct Vtx::Vortex *) malloc(sizeof(struct Vtx::Vortex)*cap);
+		char line[256];
+		while (fgets(line, sizeof(line), f) != NULL){
+			struct Vtx::Vortex w;
+			if (line[0] == '#' || sscanf(line, "%d,%lf,%d,%lf,%d,%u", &w.coords.x, &w.coordsD.x, &w.coords.y, &w.coordsD.y, &w.wind, &w.uid) != 6)
+				continue;
+			if (*length == cap){
+				cap *= 2;
+				v = (struct Vtx::Vortex *) realloc(v, sizeof(struct Vtx::Vortex)*cap);
+			}
+			v[(*length)++] = w;
+		}
+		fclose(f);
+		return v;
+	}
+
+	/*
+	 * Appends the defect counts of one sample.
+	 */
+	void writeOutDefects(char* buffer, char *file, int step, int num, unsigned int defects, unsigned int *count, int fromStep){
+		FILE *f;
+		sprintf (buffer, "%s", file);
+		f = openSeries(buffer, fromStep);
+		if (f == NULL)
+			return;
+		if (ftell(f) == 0)
+			fprintf (f, "#STEP,VORTICES,DEFECTS,Z0,Z1,Z2,Z3,Z4,Z5,Z6,Z7,Z8,Z9+\n");
+		fprintf (f, "%d,%d,%u", step, num, defects);
+		for (int z = 0; z < 10; z++)
+			fprintf (f, ",%u", count[z]);
+		fprintf (f, "\n");
+		fclose (f);
+	}
+
+	/*
+	 * Rows are kept up to the first one that is not before fromStep and in
+	 * step order. Comment lines are kept; a last line without its newline
+	 * was cut short by a crash, and goes too.
+	 */
+	FILE *openSeries(const char *file, int fromStep){
+		if(!series.insert(file).second)
+			return fopen(file, "a");
+		FILE *f = (fromStep < 0) ? NULL : fopen(file, "r+");
+		if(f == NULL)
+			return fopen(file, "w");
+		char *line = NULL;
+		size_t cap = 0;
+		ssize_t len;
+		long long keep = 0;
+		int step, last = INT_MIN;
+		while((len = getline(&line, &cap, f)) > 0 && line[len-1] == '\n'){
+			if(line[0] != '#'){
+				if(sscanf(line, "%d", &step) != 1 || step >= fromStep || step < last)
+					break;
+				last = step;
+			}
+			keep += len;
+		}
+		free(line);
+		if(ftruncate(fileno(f), keep) != 0 || fseeko(f, keep, SEEK_SET) != 0){
+			fprintf(stderr,"Cannot truncate %s\n",file);
+			fclose(f);
+			return NULL;
+		}
+		return f;
+	}
+
+	/*
+	 * The header holds the centre of each shell, so rows from runs with the
+	 * same grid can be concatenated.
+	 */
+	void writeOutSpectrum(char* buffer, const char *file, int step, double dk, int bins, double total, double *e, int fromStep){
+		FILE *f;
+		sprintf (buffer, "%s", file);
+		f = openSeries(buffer, fromStep);
+		if (f == NULL)
+			return;
+		if (ftell(f) == 0){
+			fprintf (f, "#STEP,TOTAL");
+			for (int b = 0; b < bins; b++)
+				fprintf (f, ",%e", (b + 0.5)*dk);
+			fprintf (f, "\n");
+		}
+		fprintf (f, "%d,%e", step, total);
+		for (int b = 0; b < bins; b++)
+			fprintf (f, ",%e", e[b]);
+		fprintf (f, "\n");
+		fclose (f);
+	}
+
+	void writeOutStructure(char* buffer, const char *file, double dk, int bins, double *mean, double *var, int step){
+		FILE *f;
+		sprintf (buffer, "%s_%d", file, step);
+		f = fopen (buffer,"w");
+		fprintf (f, "#K,MEAN,VAR\n");
+		for (int b = 0; b < bins; b++)
+			fprintf (f, "%e,%e,%e\n", (b + 0.5)*dk, mean[b], var[b]);
+		fclose (f);
+	}
+
+	void writeOutFlow(char* buffer, const char *file, int nx, int ny, double x0, double y0, double hx, double hy, double *density, double2 *current, double2 *velocity, double *vorticity, int step){
+		FILE *f;
+		sprintf (buffer, "%s_%d", file, step);
+		f = fopen (buffer,"w");
+		fprintf (f, "#X,Y,DENSITY,JX,JY,VX,VY,VORTICITY\n");
+		writeBlocks(f, nx*ny, 192, [&](int i, char *out){
+			return snprintf(out, 192, "%e,%e,%e,%e,%e,%e,%e,%e\n", x0 + (i/ny)*hx, y0 + (i%ny)*hy, density[i],
+			                current[i].x, current[i].y, velocity[i].x, velocity[i].y, vorticity[i]);
+		});
 		fclose (f);
 	}
 
@@ -160,6 +694,24 @@ namespace FileIO{
 		return 0;
 	}
 
+	/*
+	 * Formats one adjacency matrix row as "{a,b,...}" with a trailing comma
+	 * if more rows follow. Returns the number of characters written.
+	 */
+	template <typename T>
+	static int adjMatRow(char *out, T *row, int dim, bool more){
+		int n = 0;
+		out[n++] = '{';
+		for(int jj = 0; jj < dim; ++jj){
+			n += snprintf(out + n, 16, "%e", (double) row[jj]);
+			out[n++] = (jj<dim-1) ? ',' : '}';
+		}
+		if(more)
+			out[n++] = ',';
+		out[n++] = '\n';
+		return n;
+	}
+
 	/*
 	 * Outputs the adjacency matrix to a file
 	 */
@@ -173,19 +725,9 @@ namespace FileIO{
 		}
 		fprintf (f, "*)\n");
 	    fprintf (f, "{\n");
-	    for(int ii = 0; ii < dim; ++ii){
-		    fprintf (f, "{");
-		    for(int jj = 0; jj < dim; ++jj){
-			    fprintf (f, "%e",mat[ii*dim + jj]);
-			    if(jj<dim-1)
-				    fprintf (f, ",");
-			    else
-				    fprintf (f, "}");
-		    }
-		    if(ii<dim-1)
-			    fprintf (f, ",");
-		    fprintf (f, "\n");
-	    }
+	    writeBlocks(f, dim, 16*dim + 8, [&](int ii, char *out){
+		    return adjMatRow(out, mat + (size_t) ii*dim, dim, ii < dim-1);
+	    });
 	    fprintf (f, "}\n");
 		fclose(f);
     }
@@ -197,25 +739,109 @@ namespace FileIO{
 	    for(int ii = 0; ii<dim; ++ii){
 		    fprintf (f, "%d",uids[ii]);
 		    if(ii!=dim-1)
-			    fprintf (f, ",",uids[ii]);
+			    fprintf (f, ",");
 
 	    }
 	    fprintf (f, "*)\n");
 	    fprintf (f, "{\n");
-	    for(int ii = 0; ii < dim; ++ii){
-		    fprintf (f, "{");
-		    for(int jj = 0; jj < dim; ++jj){
-			    fprintf (f, "%e",mat[ii*dim + jj]);
-			    if(jj<dim-1)
-				    fprintf (f, ",");
-			    else
-				    fprintf (f, "}");
-		    }
-		    if(ii<dim-1)
-			    fprintf (f, ",");
-		    fprintf (f, "\n");
-	    }
+	    writeBlocks(f, dim, 16*dim + 8, [&](int ii, char *out){
+		    return adjMatRow(out, mat + (size_t) ii*dim, dim, ii < dim-1);
+	    });
 	    fprintf (f, "}\n");
 	    fclose(f);
     }
+
+	/*
+	 * Opens a binary graph file and writes its header and UID table.
+	 */
+	static FILE *openGraphBin(char* buffer, char *file, unsigned int format, unsigned int *uids, int dim, unsigned int numEdges, int step){
+		GraphHeader h;
+		memcpy(h.magic,"GPUG",4);
+		h.version = 1;
+		h.format = format;
+		h.step = step;
+		h.numVortices = dim;
+		h.numEdges = numEdges;
+		sprintf (buffer, "%s_%d.bin", file, step);
+		FILE *f = fopen (buffer,"wb");
+		fwrite (&h, sizeof(GraphHeader), 1, f);
+		fwrite (uids, sizeof(unsigned int), dim, f);
+		return f;
+	}
+
+	/*
+	 * Writes each edge from the row of its lower index. Text rows are sized
+	 * by the largest degree.
+	 */
+	void writeOutEdgeList(char* buffer, char *file, unsigned int *uids, const unsigned int *rowPtr, const unsigned int *colIdx, const double *colWeight, int dim, bool binary, int step){
+		FILE *f;
+		unsigned int numEdges = rowPtr[dim]/2, maxDeg = 0;
+		for (int ii = 0; ii < dim; ++ii)
+			if (rowPtr[ii+1] - rowPtr[ii] > maxDeg)
+				maxDeg = rowPtr[ii+1] - rowPtr[ii];
+		if (binary){
+			std::vector<unsigned int> a, b;
+			std::vector<double> w;
+			a.reserve(numEdges); b.reserve(numEdges); w.reserve(numEdges);
+			for (int ii = 0; ii < dim; ++ii){
+				for (unsigned int k = rowPtr[ii]; k < rowPtr[ii+1]; ++k){
+					if (colIdx[k] > (unsigned int) ii){
+						a.push_back(ii);
+						b.push_back(colIdx[k]);
+						w.push_back(colWeight[k]);
+					}
+				}
+			}
+			f = openGraphBin(buffer, file, 0, uids, dim, numEdges, step);
+			fwrite (a.data(), sizeof(unsigned int), a.size(), f);
+			fwrite (b.data(), sizeof(unsigned int), b.size(), f);
+			fwrite (w.data(), sizeof(double), w.size(), f);
+			fclose (f);
+			return;
+		}
+		sprintf (buffer, "%s_%d", file, step);
+		f = fopen (buffer,"w");
+		fprintf (f, "#UID_A,UID_B,WEIGHT\n");
+		writeBlocks(f, dim, 48*maxDeg + 1, [&](int ii, char *out){
+			int n = 0;
+			for (unsigned int k = rowPtr[ii]; k < rowPtr[ii+1]; ++k)
+				if (colIdx[k] > (unsigned int) ii)
+					n += snprintf(out + n, 48, "%u,%u,%e\n", uids[ii], uids[colIdx[k]], colWeight[k]);
+			return n;
+		});
+		fclose (f);
+	}
+
+	void writeOutCSR(char* buffer, char *file, unsigned int *uids, const unsigned int *rowPtr, const unsigned int *colIdx, const double *colWeight, int dim, bool binary, int step){
+		FILE *f;
+		unsigned int nnz = rowPtr[dim];
+		if (binary){
+			f = openGraphBin(buffer, file, 1, uids, dim, nnz/2, step);
+			fwrite (rowPtr, sizeof(unsigned int), dim + 1, f);
+			fwrite (colIdx, sizeof(unsigned int), nnz, f);
+			fwrite (colWeight, sizeof(double), nnz, f);
+			fclose (f);
+			return;
+		}
+		sprintf (buffer, "%s_%d", file, step);
+		f = fopen (buffer,"w");
+		fprintf (f, "#UIDS,ROWPTR,COLIDX,WEIGHT\n");
+		writeBlocks(f, dim, 16, [&](int ii, char *out){
+			return snprintf(out, 16, ii < dim-1 ? "%u," : "%u", uids[ii]);
+		});
+		fprintf (f, "\n");
+		writeBlocks(f, dim + 1, 16, [&](int ii, char *out){
+			return snprintf(out, 16, ii < dim ? "%u," : "%u", rowPtr[ii]);
+		});
+		fprintf (f, "\n");
+		writeBlocks(f, nnz, 16, [&](int k, char *out){
+			return snprintf(out, 16, k < (int) nnz-1 ? "%u," : "%u", colIdx[k]);
+		});
+		fprintf (f, "\n");
+		writeBlocks(f, nnz, 24, [&](int k, char *out){
+			return snprintf(out, 24, k < (int) nnz-1 ? "%e," : "%e", colWeight[k]);
+		});
+		fprintf (f, "\n");
+		fclose (f);
+	}
 }
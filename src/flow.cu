@@ -0,0 +1,94 @@
+/*** flow.cu - GPUE: Split Operator based GPU solver for Nonlinear
+Schrodinger Equation, Copyright (C) 2011-2015, Lee J. O'Riordan
+<loriordan@gmail.com>, Tadhg Morgan, Neil Crowley.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "../include/flow.h"
+#include "../include/kernels.h"
+#include "../include/constants.h"
+
+namespace Flow {
+
+	static const int threads = 256;
+
+	Fields::Fields(int xDim, int yDim, double dx, double dy, int stride){
+		this->xDim = xDim;
+		this->yDim = yDim;
+		this->stride = (stride < 1) ? 1 : stride;
+		nx = (xDim + this->stride - 1)/this->stride;
+		ny = (yDim + this->stride - 1)/this->stride;
+		dkx = 2*PI/(xDim*dx);
+		dky = 2*PI/(yDim*dy);
+		cufftPlan2d(&plan, xDim, yDim, CUFFT_Z2Z);
+		cudaMalloc((void**) &gpuA, sizeof(double2)*xDim*yDim);
+		cudaMalloc((void**) &gpuB, sizeof(double2)*xDim*yDim);
+		cudaMalloc((void**) &gpuDensity, sizeof(double)*nx*ny);
+		cudaMalloc((void**) &gpuVorticity, sizeof(double)*nx*ny);
+		cudaMalloc((void**) &gpuCurrent, sizeof(double2)*nx*ny);
+		cudaMalloc((void**) &gpuVelocity, sizeof(double2)*nx*ny);
+	}
+
+	Fields::~Fields(){
+		cufftDestroy(plan);
+		cudaFree(gpuA);
+		cudaFree(gpuB);
+		cudaFree(gpuDensity);
+		cudaFree(gpuVorticity);
+		cudaFree(gpuCurrent);
+		cudaFree(gpuVelocity);
+	}
+
+	int2 Fields::getDims(){
+		return make_int2(nx, ny);
+	}
+
+	/*
+	 * Three transforms: psi forward and its two derivatives back. Only the
+	 * decimated fields cross the bus.
+	 */
+	void Fields::compute(double2 *gpuWfc, double mass, double *density, double2 *current, double2 *velocity, double *vorticity){
+		int n = xDim*yDim;
+		cufftExecZ2Z(plan, gpuWfc, gpuA, CUFFT_FORWARD);
+		specGradient<<<(n + threads - 1)/threads, threads>>>(gpuA, gpuB, gpuA, xDim, yDim, dkx, dky, 1.0/n);
+		cufftExecZ2Z(plan, gpuB, gpuB, CUFFT_INVERSE);
+		cufftExecZ2Z(plan, gpuA, gpuA, CUFFT_INVERSE);
+		flowFields<<<(nx*ny + threads - 1)/threads, threads>>>(gpuWfc, gpuB, gpuA, xDim, yDim, stride, HBAR/mass,
+		                                                       gpuDensity, gpuCurrent, gpuVelocity, gpuVorticity);
+		if(density != NULL)
+			cudaMemcpy(density, gpuDensity, sizeof(double)*nx*ny, cudaMemcpyDeviceToHost);
+		if(current != NULL)
+			cudaMemcpy(current, gpuCurrent, sizeof(double2)*nx*ny, cudaMemcpyDeviceToHost);
+		if(velocity != NULL)
+			cudaMemcpy(velocity, gpuVelocity, sizeof(double2)*nx*ny, cudaMemcpyDeviceToHost);
+		if(vorticity != NULL)
+			cudaMemcpy(vorticity, gpuVorticity, sizeof(double)*nx*ny, cudaMemcpyDeviceToHost);
+	}
+}
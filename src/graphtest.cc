@@ -7,17 +7,210 @@
 #include "../include/lattice.h"
 #include "../include/node.h"
 #include "../include/edge.h"
+#include "../include/trajfile.h"
+#include <cstdio>
+#include <cmath>
 #include <iostream>
 #include <vector>
 #include <algorithm>
 #include <iterator>
 #include <algorithm>
+#include <set>
 
 using namespace LatticeGraph;
 unsigned int Edge::suid = 0;
 unsigned int Node::suid = 0;
 
+typedef std::set< std::pair<unsigned int, unsigned int> > EdgeSet;
+
+/*
+ * Delaunay edges by brute force: every triangle whose circumcircle holds no
+ * other vortex.
+ */
+EdgeSet delaunayBrute(const std::vector<Vtx::Vortex> &v){
+	EdgeSet s;
+	int n = v.size();
+	for(int i = 0; i < n; ++i){
+		for(int j = i + 1; j < n; ++j){
+			for(int k = j + 1; k < n; ++k){
+				int a = i, b = j, c = k;
+				double o = (v[b].coordsD.x - v[a].coordsD.x)*(v[c].coordsD.y - v[a].coordsD.y)
+				         - (v[b].coordsD.y - v[a].coordsD.y)*(v[c].coordsD.x - v[a].coordsD.x);
+				if(o == 0.0)
+					continue;
+				if(o < 0.0)
+					std::swap(b, c);
+				bool empty = true;
+				for(int p = 0; p < n && empty; ++p){
+					if(p == a || p == b || p == c)
+						continue;
+					double adx = v[a].coordsD.x - v[p].coordsD.x, ady = v[a].coordsD.y - v[p].coordsD.y;
+					double bdx = v[b].coordsD.x - v[p].coordsD.x, bdy = v[b].coordsD.y - v[p].coordsD.y;
+					double cdx = v[c].coordsD.x - v[p].coordsD.x, cdy = v[c].coordsD.y - v[p].coordsD.y;
+					empty = (adx*adx + ady*ady)*(bdx*cdy - cdx*bdy)
+					      + (bdx*bdx + bdy*bdy)*(cdx*ady - adx*cdy)
+					      + (cdx*cdx + cdy*cdy)*(adx*bdy - bdx*ady) <= 0.0;
+				}
+				if(empty){
+					s.insert(std::make_pair(i, j));
+					s.insert(std::make_pair(i, k));
+					s.insert(std::make_pair(j, k));
+				}
+			}
+		}
+	}
+	return s;
+}
+
+EdgeSet delaunayEdges(Delaunay &d){
+	EdgeSet s;
+	for(size_t e = 0; e < d.getEdgeA().size(); ++e)
+		s.insert(std::make_pair(d.getEdgeA()[e], d.getEdgeB()[e]));
+	return s;
+}
+
+double uniform(){
+	return rand()/(RAND_MAX + 1.0);
+}
+
+/*
+ * Compares triangulate() and update() against the brute force on random
+ * vortex sets, with vortices moving, dying, being born and jumping between
+ * updates. Returns the number of mismatches.
+ */
+int delaunayCheck(){
+	int bad = 0, frames = 0;
+	unsigned int uid = 0;
+	srand(43);
+	for(int trial = 0; trial < 500; ++trial){
+		double scale = (trial % 3 == 0) ? 1000.0 : (trial % 3 == 1) ? 10.0 : 1.0;
+		std::vector<Vtx::Vortex> v(4 + rand() % 40);
+		for(auto &w : v){
+			w.uid = uid++;
+			w.coordsD.x = uniform()*scale*((trial % 5 == 0) ? 0.05 : 1.0);
+			w.coordsD.y = uniform()*scale;
+		}
+		Delaunay d;
+		d.triangulate(v.data(), v.size());
+		bad += delaunayEdges(d) != delaunayBrute(v);
+		++frames;
+		for(int f = 0; f < 8; ++f){
+			for(auto &w : v){
+				if(uniform() < 0.5){
+					w.coordsD.x += (uniform() - 0.5)*0.05*scale;
+					w.coordsD.y += (uniform() - 0.5)*0.05*scale;
+				}
+			}
+			if(uniform() < 0.5 && v.size() > 4)
+				v.erase(v.begin() + rand() % v.size());
+			if(uniform() < 0.5){
+				Vtx::Vortex w;
+				w.uid = uid++;
+				w.coordsD.x = (1.5*uniform() - 0.25)*scale;
+				w.coordsD.y = (1.5*uniform() - 0.25)*scale;
+				v.insert(v.begin() + rand() % (v.size() + 1), w);
+			}
+			if(uniform() < 0.2){
+				Vtx::Vortex &w = v[rand() % v.size()];
+				w.coordsD.x = uniform()*scale;
+				w.coordsD.y = uniform()*scale;
+			}
+			d.update(v.data(), v.size());
+			bad += delaunayEdges(d) != delaunayBrute(v);
+			++frames;
+		}
+	}
+	std::cout << "Delaunay: " << bad << " of " << frames << " frames differ from brute force" << std::endl;
+	return bad;
+}
+
+static bool byUidStep(const TrajFile::Record &a, const TrajFile::Record &b){
+	return a.uid < b.uid || (a.uid == b.uid && a.step < b.step);
+}
+
+static bool sameRecords(const std::vector<TrajFile::Record> &a, const std::vector<TrajFile::Record> &b){
+	if(a.size() != b.size())
+		return false;
+	for(size_t i = 0; i < a.size(); ++i){
+		if(a[i].uid != b[i].uid || a[i].step != b[i].step || a[i].wind != b[i].wind
+		   || fabs(a[i].x - b[i].x) > 1e-6 || fabs(a[i].y - b[i].y) > 1e-6)
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Writes a trajectory file, reopens it at a cut step as a resumed run does,
+ * and appends a second run from there. Vortices are born and die part way
+ * through blocks, and the cut usually falls inside a block. The reader must
+ * return the first run's samples before the cut and the second run's after
+ * it, both in full and one vortex at a time. Returns the number of
+ * mismatching files.
+ */
+int trajCheck(){
+	char file[] = "graphtest_traj";
+	int bad = 0, trials = 100;
+	srand(37);
+	for(int trial = 0; trial < trials; ++trial){
+		int blockLen = 1 + rand() % 200, cut = 10*(rand() % 40), end[2] = {300 + 10*(rand() % 10), 500};
+		std::vector<TrajFile::Record> expect;
+		bool ok = true;
+		for(int run = 0; run < 2 && ok; ++run){
+			TrajFile::Writer w;
+			ok = w.open(file, run ? cut : -1, blockLen) == 0;
+			std::vector<Vtx::Vortex> v;
+			unsigned int uid = 0;
+			for(int step = run ? cut : 0; step < end[run] && ok; step += 10){
+				for(size_t k = 0; k < v.size();){
+					if(uniform() < 0.05)
+						v.erase(v.begin() + k);
+					else
+						++k;
+				}
+				for(int b = rand() % 4; b > 0; --b){
+					Vtx::Vortex n;
+					n.uid = uid++;
+					n.wind = (rand() % 2) ? 1 : -1;
+					n.coordsD.x = (uniform() - 0.2)*500.0;
+					n.coordsD.y = (uniform() - 0.2)*500.0;
+					v.insert(v.begin() + rand() % (v.size() + 1), n);
+				}
+				for(auto &n : v){
+					n.coordsD.x += uniform() - 0.5;
+					n.coordsD.y += uniform() - 0.5;
+					if(run == 1 || step < cut)
+						expect.push_back(TrajFile::Record{n.uid, step, n.coordsD.x, n.coordsD.y, n.wind});
+				}
+				w.append(v.data(), v.size(), step);
+			}
+			ok = ok && w.close() == 0;
+		}
+		std::vector<TrajFile::Record> all, one, want;
+		TrajFile::Reader r(file);
+		ok = ok && r.isOpen() && r.getAll(all) >= 0;
+		std::sort(all.begin(), all.end(), byUidStep);
+		std::sort(expect.begin(), expect.end(), byUidStep);
+		ok = ok && sameRecords(all, expect);
+		for(unsigned int u = 0; u < r.getUidBound() && ok; ++u){
+			want.clear();
+			for(auto &e : expect)
+				if(e.uid == u)
+					want.push_back(e);
+			ok = r.getTrajectory(u, one) >= 0 && sameRecords(one, want);
+		}
+		bad += !ok;
+	}
+	remove(file);
+	std::cout << "Trajectories: " << bad << " of " << trials << " resumed files differ from their samples" << std::endl;
+	return bad;
+}
+
 int main(){
+	int bad = delaunayCheck();
+	bad += trajCheck();
+	if(bad > 0)
+		return 1;
+
 	Lattice *l = new Lattice();
 
 	std::shared_ptr<Node> n;//
@@ -0,0 +1,128 @@
+/*** hexatic.cc - GPUE: Split Operator based GPU solver for Nonlinear
+Schrodinger Equation, Copyright (C) 2011-2015, Lee J. O'Riordan
+<loriordan@gmail.com>, Tadhg Morgan, Neil Crowley.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include "../include/hexatic.h"
+#include "../include/paircorr.h"
+#include "../include/fileIO.h"
+
+namespace Hexatic {
+
+	/*
+	 * exp(6i theta) of each bond is (dx + i dy)^6/r^6, so no trigonometry
+	 * is needed.
+	 */
+	void psi6(LatticeGraph::Lattice &lattice, double2 *psi){
+		const std::vector<unsigned int> &rowPtr = lattice.getRowPtr();
+		const std::vector<unsigned int> &colIdx = lattice.getColIdx();
+		int num = lattice.getNumVortices();
+		#pragma omp parallel for schedule(static)
+		for(int ii = 0; ii < num; ++ii){
+			const Vtx::Vortex &a = lattice.getVortexData(ii);
+			double re = 0.0, im = 0.0;
+			for(unsigned int k = rowPtr[ii]; k < rowPtr[ii+1]; ++k){
+				const Vtx::Vortex &b = lattice.getVortexData(colIdx[k]);
+				double dx = b.coordsD.x - a.coordsD.x, dy = b.coordsD.y - a.coordsD.y;
+				double r2 = dx*dx + dy*dy;
+				if(r2 == 0.0)
+					continue;
+				double x2 = dx*dx - dy*dy, y2 = 2.0*dx*dy; //z^2
+				double x3 = x2*dx - y2*dy, y3 = x2*dy + y2*dx; //z^3
+				re += (x3*x3 - y3*y3)/(r2*r2*r2);
+				im += 2.0*x3*y3/(r2*r2*r2);
+			}
+			unsigned int z = rowPtr[ii+1] - rowPtr[ii];
+			psi[ii].x = z ? re/z : 0.0;
+			psi[ii].y = z ? im/z : 0.0;
+		}
+	}
+
+	/*
+	 * Pairs are found as in Lattice::createEdges: a cell list no finer than
+	 * rMax, each vortex against the later ones in the 3x3 cells around it.
+	 * Each thread fills its own histogram.
+	 */
+	void g6(const Vtx::Vortex *v, const double2 *psi, int num, double rMax, int bins, double *g6, double *pairs){
+		std::vector<double2> pos(num);
+		for(int ii = 0; ii < num; ++ii)
+			pos[ii] = v[ii].coordsD;
+		PairCorr::histogram(pos.data(), num, rMax, bins, pairs, psi, g6);
+		for(int b = 0; b < bins; ++b)
+			if(pairs[b] > 0.0)
+				g6[b] /= pairs[b];
+	}
+
+	Summary summarise(LatticeGraph::Lattice &lattice, const double2 *psi, const double *area, const unsigned int *sides){
+		Summary s;
+		double re = 0.0, im = 0.0, mag = 0.0, a1 = 0.0, a2 = 0.0;
+		int cells = 0;
+		s.num = 0;
+		for(int z = 0; z < 10; ++z)
+			s.sides[z] = 0;
+		for(unsigned int ii = 0; ii < lattice.getNumVortices(); ++ii){
+			if(lattice.isOnHull(ii))
+				continue;
+			++s.num;
+			re += psi[ii].x;
+			im += psi[ii].y;
+			mag += sqrt(psi[ii].x*psi[ii].x + psi[ii].y*psi[ii].y);
+			if(sides[ii] > 0){
+				++cells;
+				a1 += area[ii];
+				a2 += area[ii]*area[ii];
+				++s.sides[std::min(sides[ii], 9u)];
+			}
+		}
+		s.psi6Mean = s.num ? mag/s.num : 0.0;
+		s.psi6Global = s.num ? sqrt(re*re + im*im)/s.num : 0.0;
+		s.areaMean = cells ? a1/cells : 0.0;
+		s.areaStd = cells ? sqrt(std::max(a2/cells - s.areaMean*s.areaMean, 0.0)) : 0.0;
+		return s;
+	}
+
+	void writeSummary(const char *file, int step, const Summary &s, int fromStep){
+		FILE *f = FileIO::openSeries(file, fromStep);
+		if(f == NULL)
+			return;
+		if(ftell(f) == 0)
+			fprintf(f, "#STEP,VORTICES,PSI6_MEAN,PSI6_GLOBAL,AREA_MEAN,AREA_STD,S0,S1,S2,S3,S4,S5,S6,S7,S8,S9+\n");
+		fprintf(f, "%d,%d,%e,%e,%e,%e", step, s.num, s.psi6Mean, s.psi6Global, s.areaMean, s.areaStd);
+		for(int z = 0; z < 10; ++z)
+			fprintf(f, ",%u", s.sides[z]);
+		fprintf(f, "\n");
+		fclose(f);
+	}
+}
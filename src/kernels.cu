@@ -32,6 +32,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "../include/constants.h"
+#include "../include/vort.h"
 #include <stdio.h>
 
 
@@ -163,6 +164,318 @@ __global__ void scalarDiv_wfcNorm(double2* in, double dr, double2* pSum, double2
 	out[gid] = result;
 }
 
+/**
+ * Keeps the modes |k| < n/2 along each axis. Launched over the output grid.
+ */
+__global__ void fftCrop(double2* in, double2* out, int xDim, int yDim, int nx, int ny, double factor){
+	unsigned int gid = getGid3d3d();
+	if(gid >= nx*ny)
+		return;
+	int i = gid/ny, j = gid%ny;
+	int si = (i < nx/2) ? i : xDim - (nx - i);
+	int sj = (j < ny/2) ? j : yDim - (ny - j);
+	out[gid] = realCompMult(factor, in[si*yDim + sj]);
+}
+
+/*
+ * Branch cut crossing of the phase step a -> b. See Tracker::findVortex.
+ */
+__device__ int cutCrossing(double2 a, double2 b){
+	double c = a.x*b.y - a.y*b.x;
+	int ua = (a.y > 0.0) || (a.y == 0.0 && a.x < 0.0);
+	int ub = (b.y > 0.0) || (b.y == 0.0 && b.x < 0.0);
+	return (ua && !ub && c >= 0.0) - (!ua && ub && c < 0.0);
+}
+
+__device__ int plaquetteWinding(double2* wfc, int2* span, int i, int j, int xDim){
+	if(i < 0 || i >= xDim-1 || j < span[i].x || j > span[i].y)
+		return 0;
+	double2 p0 = wfc[i*xDim + j], p1 = wfc[(i+1)*xDim + j];
+	double2 p2 = wfc[(i+1)*xDim + (j+1)], p3 = wfc[i*xDim + (j+1)];
+	return cutCrossing(p0,p1) + cutCrossing(p1,p2) + cutCrossing(p2,p3) + cutCrossing(p3,p0);
+}
+
+/*
+ * Winding of plaquette (i,j) if it is a vortex after dropping same-sign
+ * neighbours to the left and above, else 0.
+ */
+__device__ int vortexAt(double2* wfc, int2* span, int i, int j, int xDim){
+	int wind = plaquetteWinding(wfc, span, i, j, xDim);
+	if(wind == 0)
+		return 0;
+	if(plaquetteWinding(wfc, span, i, j-1, xDim) == wind ||
+	   plaquetteWinding(wfc, span, i-1, j-1, xDim) == wind ||
+	   plaquetteWinding(wfc, span, i-1, j, xDim) == wind ||
+	   plaquetteWinding(wfc, span, i-1, j+1, xDim) == wind)
+		return 0;
+	return wind;
+}
+
+__global__ void findVortexGPU(double2* wfc, int2* span, int xDim, struct Vtx::Vortex* vort, int* count, int cap){
+	unsigned int gid = getGid3d3d();
+	if(gid >= xDim*xDim)
+		return;
+	int i = gid/xDim, j = gid%xDim;
+	int wind = vortexAt(wfc, span, i, j, xDim);
+	if(wind == 0)
+		return;
+	int idx = atomicAdd(count, 1);
+	if(idx < cap){
+		vort[idx].coords.x = i;
+		vort[idx].coords.y = j;
+		vort[idx].wind = wind;
+	}
+}
+
+__global__ void trackVortexWindow(double2* wfc, int2* span, int xDim, struct Vtx::Vortex* prev, int numPrev, int win, unsigned int* stamp, unsigned int epoch, struct Vtx::Vortex* vort, int* count, int cap){
+	unsigned int gid = getGid3d3d();
+	int side = 2*win + 1;
+	if(gid >= numPrev*side*side)
+		return;
+	int k = gid/(side*side), off = gid%(side*side);
+	int i = prev[k].coords.x + off/side - win;
+	int j = prev[k].coords.y + off%side - win;
+	int wind = vortexAt(wfc, span, i, j, xDim);
+	if(wind == 0)
+		return;
+	if(atomicExch(&stamp[i*xDim + j], epoch) == epoch) //Already taken by an overlapping window
+		return;
+	int idx = atomicAdd(count, 1);
+	if(idx < cap){
+		vort[idx].coords.x = i;
+		vort[idx].coords.y = j;
+		vort[idx].wind = wind;
+	}
+}
+
+__global__ void rowDensityMax(double2* wfc, int xDim, double* rowMax){
+	unsigned int i = getGid3d3d();
+	if(i >= xDim)
+		return;
+	double m = 0.0;
+	for(int j = 0; j < xDim; ++j)
+		m = fmax(m, complexMagnitudeSquared(wfc[i*xDim + j]));
+	rowMax[i] = m;
+}
+
+__global__ void densitySpan(double2* wfc, double* x, double r2, double thresh, int xDim, int2* span){
+	unsigned int i = getGid3d3d();
+	int n = xDim - 1;
+	if(i >= n)
+		return;
+	int a = n, b = -1;
+	for(int j = 0; j < n; ++j){
+		if(x[i]*x[i] + x[j]*x[j] >= r2)
+			continue;
+		double d = fmin(fmin(complexMagnitudeSquared(wfc[i*xDim + j]), complexMagnitudeSquared(wfc[i*xDim + (j+1)])),
+		                fmin(complexMagnitudeSquared(wfc[(i+1)*xDim + j]), complexMagnitudeSquared(wfc[(i+1)*xDim + (j+1)])));
+		if(d >= thresh){
+			if(a == n)
+				a = j;
+			b = j;
+		}
+	}
+	span[i].x = (a <= b) ? a : 1;
+	span[i].y = (a <= b) ? b : 0;
+}
+
+__global__ void boundaryWinding(double2* wfc, int2* span, int xDim, int* sum){
+	unsigned int i = getGid3d3d();
+	int n = xDim - 1;
+	if(i >= n)
+		return;
+	int a = span[i].x, b = span[i].y, j, w = 0;
+	if(a > b)
+		return;
+	int a1 = b + 1, b1 = b, a0 = b + 1, b0 = b; //Neighbour row spans, empty by default
+	if(i+1 < n && span[i+1].x <= span[i+1].y){ a1 = span[i+1].x; b1 = span[i+1].y; }
+	if(i > 0 && span[i-1].x <= span[i-1].y){ a0 = span[i-1].x; b0 = span[i-1].y; }
+	w += cutCrossing(wfc[i*xDim + a], wfc[(i+1)*xDim + a]);
+	w += cutCrossing(wfc[(i+1)*xDim + (b+1)], wfc[i*xDim + (b+1)]);
+	for(j = a; j <= b && j < a1; ++j)
+		w += cutCrossing(wfc[(i+1)*xDim + j], wfc[(i+1)*xDim + (j+1)]);
+	for(j = (b1 + 1 > a) ? b1 + 1 : a; j <= b; ++j)
+		w += cutCrossing(wfc[(i+1)*xDim + j], wfc[(i+1)*xDim + (j+1)]);
+	for(j = a; j <= b && j < a0; ++j)
+		w += cutCrossing(wfc[i*xDim + (j+1)], wfc[i*xDim + j]);
+	for(j = (b0 + 1 > a) ? b0 + 1 : a; j <= b; ++j)
+		w += cutCrossing(wfc[i*xDim + (j+1)], wfc[i*xDim + j]);
+	if(w != 0)
+		atomicAdd(sum, w);
+}
+
+/*
+ * Fits a plane to the stencil x stencil points around each core and solves
+ * for its zero. Same fit as Tracker::lsFit; stencil is 2 or 4.
+ */
+__global__ void lsFitGPU(double2* wfc, struct Vtx::Vortex* vort, int num, int xDim, int stencil){
+	unsigned int gid = getGid3d3d();
+	if(gid >= num)
+		return;
+	int S = stencil;
+	int o0 = -(S - 1)/2;
+	double m = o0 + 0.5*(S - 1);
+	double sxx = 0.0;
+	for(int k = 0; k < S; ++k)
+		sxx += S*(o0 + k - m)*(o0 + k - m);
+	int i = vort[gid].coords.x, j = vort[gid].coords.y;
+	double2 a = {0.0, 0.0}, b = {0.0, 0.0}, c = {0.0, 0.0};
+	for(int p = 0; p < S; ++p){
+		int ip = min(max(i + o0 + p, 0), xDim - 1);
+		double wp = (o0 + p - m)/sxx;
+		for(int q = 0; q < S; ++q){
+			double2 v = wfc[ip*xDim + min(max(j + o0 + q, 0), xDim - 1)];
+			double wq = (o0 + q - m)/sxx;
+			a.x += v.x; a.y += v.y;
+			b.x += wp*v.x; b.y += wp*v.y;
+			c.x += wq*v.x; c.y += wq*v.y;
+		}
+	}
+	a.x /= S*S; a.y /= S*S;
+	double det = 1.0/(b.x*c.y - c.x*b.y);
+	vort[gid].coordsD.x = i + m + det*(c.x*a.y - c.y*a.x);
+	vort[gid].coordsD.y = j + m + det*(b.y*a.x - b.x*a.y);
+}
+
+/*
+ * Wavenumber of FFT index i on an n point axis, with the Nyquist mode of an
+ * even axis mapped to 0 for odd-order derivatives.
+ */
+__device__ double fftWavenumber(int i, int n, double dk){
+	if(2*i == n)
+		return 0.0;
+	return dk*((2*i < n) ? i : i - n);
+}
+
+/*
+ * i*k times the transform. outY may alias in; outX may not.
+ */
+__global__ void specGradient(double2* in, double2* outX, double2* outY, int xDim, int yDim, double dkx, double dky, double factor){
+	unsigned int gid = getGid3d3d();
+	if(gid >= xDim*yDim)
+		return;
+	double kx = factor*fftWavenumber(gid/yDim, xDim, dkx);
+	double ky = factor*fftWavenumber(gid%yDim, yDim, dky);
+	double2 v = in[gid];
+	outX[gid] = make_double2(-kx*v.y, kx*v.x);
+	outY[gid] = make_double2(-ky*v.y, ky*v.x);
+}
+
+/*
+ * Im(conj(psi) grad psi)/|psi| is bounded by |grad psi| at the cores, so
+ * only exact zeros of psi need guarding. out may alias gradX.
+ */
+__global__ void packedVelocity(double2* wfc, double2* gradX, double2* gradY, double hbarM, int n, double2* out){
+	unsigned int gid = getGid3d3d();
+	if(gid >= n)
+		return;
+	double2 psi = wfc[gid], gx = gradX[gid], gy = gradY[gid];
+	double mag = sqrt(complexMagnitudeSquared(psi));
+	double norm = (mag > 0.0) ? hbarM/mag : 0.0;
+	out[gid] = make_double2(norm*(psi.x*gx.y - psi.y*gx.x), norm*(psi.x*gy.y - psi.y*gy.x));
+}
+
+/*
+ * The transforms of the real fields ux and uy are unpacked from W(k) and
+ * W(-k). The k = 0 mode has no compressible part.
+ */
+__global__ void kineticShells(double2* w, int* modes, int* shellStart, int xDim, int yDim, double dkx, double dky, double* out){
+	extern __shared__ double shellSum[];
+	int shell = blockIdx.x, tid = threadIdx.x;
+	double ec = 0.0, ei = 0.0;
+	for(int k = shellStart[shell] + tid; k < shellStart[shell + 1]; k += blockDim.x){
+		int m = modes[k];
+		int i = m/yDim, j = m%yDim;
+		double2 a = w[m], b = w[((xDim - i) % xDim)*yDim + (yDim - j) % yDim];
+		double2 ux = make_double2(0.5*(a.x + b.x), 0.5*(a.y - b.y));
+		double2 uy = make_double2(0.5*(a.y + b.y), -0.5*(a.x - b.x));
+		double kx = dkx*((2*i <= xDim) ? i : i - xDim), ky = dky*((2*j <= yDim) ? j : j - yDim);
+		double k2 = kx*kx + ky*ky;
+		double u2 = complexMagnitudeSquared(ux) + complexMagnitudeSquared(uy);
+		double c2 = (k2 > 0.0) ? complexMagnitudeSquared(make_double2(kx*ux.x + ky*uy.x, kx*ux.y + ky*uy.y))/k2 : 0.0;
+		ec += c2;
+		ei += u2 - c2;
+	}
+	shellSum[tid] = ec;
+	shellSum[blockDim.x + tid] = ei;
+	__syncthreads();
+	for(int s = blockDim.x >> 1; s > 0; s >>= 1){
+		if(tid < s){
+			shellSum[tid] += shellSum[tid + s];
+			shellSum[blockDim.x + tid] += shellSum[blockDim.x + tid + s];
+		}
+		__syncthreads();
+	}
+	if(tid == 0){
+		out[shell] = shellSum[0];
+		out[gridDim.x + shell] = shellSum[blockDim.x];
+	}
+}
+
+__global__ void densityField(double2* wfc, int n, double* out){
+	unsigned int gid = getGid3d3d();
+	if(gid >= n)
+		return;
+	out[gid] = complexMagnitudeSquared(wfc[gid]);
+}
+
+/*
+ * Welford update of the mean and summed squared deviation of S(k) at each
+ * stored mode. S(k) = scale*|n_k|^2/n_0.
+ */
+__global__ void structureAccumulate(double2* nk, double scale, int samples, int n, double* mean, double* m2){
+	unsigned int gid = getGid3d3d();
+	if(gid >= n)
+		return;
+	double sk = scale*complexMagnitudeSquared(nk[gid])/nk[0].x;
+	double delta = sk - mean[gid];
+	mean[gid] += delta/samples;
+	m2[gid] += delta*(sk - mean[gid]);
+}
+
+/*
+ * Columns 0 < j < yDim/2 of the half spectrum stand for the modes at k and
+ * -k, so they count twice.
+ */
+__global__ void structureShells(double2* nk, int* modes, int* shellStart, int yDim, double scale, double* out){
+	extern __shared__ double shellSum[];
+	int shell = blockIdx.x, tid = threadIdx.x, yHalf = yDim/2 + 1;
+	double sum = 0.0;
+	for(int k = shellStart[shell] + tid; k < shellStart[shell + 1]; k += blockDim.x){
+		int m = modes[k], j = m % yHalf;
+		double w = (j == 0 || 2*j == yDim) ? 1.0 : 2.0;
+		sum += w*scale*complexMagnitudeSquared(nk[m])/nk[0].x;
+	}
+	shellSum[tid] = sum;
+	__syncthreads();
+	for(int s = blockDim.x >> 1; s > 0; s >>= 1){
+		if(tid < s)
+			shellSum[tid] += shellSum[tid + s];
+		__syncthreads();
+	}
+	if(tid == 0)
+		out[shell] = shellSum[0];
+}
+
+/*
+ * With j = hbarM Im(conj(psi) grad psi), curl j = 2 hbarM Im(conj(psi_x) psi_y)
+ * needs no further derivatives. Launched over the decimated grid.
+ */
+__global__ void flowFields(double2* wfc, double2* gradX, double2* gradY, int xDim, int yDim, int stride, double hbarM, double* density, double2* current, double2* velocity, double* vorticity){
+	unsigned int gid = getGid3d3d();
+	int ny = (yDim + stride - 1)/stride;
+	if(gid >= ((xDim + stride - 1)/stride)*ny)
+		return;
+	int src = (gid/ny)*stride*yDim + (gid%ny)*stride;
+	double2 psi = wfc[src], gx = gradX[src], gy = gradY[src];
+	double n = complexMagnitudeSquared(psi);
+	double2 j = make_double2(hbarM*(psi.x*gx.y - psi.y*gx.x), hbarM*(psi.x*gy.y - psi.y*gy.x));
+	density[gid] = n;
+	current[gid] = j;
+	velocity[gid] = (n > 0.0) ? make_double2(j.x/n, j.y/n) : make_double2(0.0, 0.0);
+	vorticity[gid] = 2.0*hbarM*(gx.x*gy.y - gx.y*gy.x);
+}
+
 __global__ void angularOp(double omega, double dt, double2* wfc, double* xpyypx, double2* out){
 	unsigned int gid = getGid3d3d();
 	double2 result;
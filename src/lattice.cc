@@ -34,7 +34,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //######################################################################################################################
 
 #include "../include/lattice.h"
+#include "../include/paircorr.h"
 #include <iostream>
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace LatticeGraph;
 
@@ -42,12 +47,248 @@ using namespace LatticeGraph;
 //####################################    Ceiling Cat & Basement Cat     ###############################################
 //######################################################################################################################
 
-Lattice::Lattice(){
+Lattice::Lattice() : arenaOut(false), nodesOut(false), edgesOut(false), csrOut(true){
 }
 
 Lattice::~Lattice(){
-	this->getVortices().clear();
-	this->getEdges().clear();
+	this->vortices.clear();
+	this->edges.clear();
+}
+
+//######################################################################################################################
+//####################################         Arena & CSR sync          ###############################################
+//######################################################################################################################
+
+static double vortexDistance(const Vtx::Vortex &v1, const Vtx::Vortex &v2){
+	return sqrt(pow(v1.coords.x - v2.coords.x,2) + pow(v1.coords.y - v2.coords.y,2));
+}
+
+/***
+ * Rebuilds the Node/Edge objects from the arena if it was modified since,
+ * in arena order so indices agree. Node edge lists are emptied before their
+ * Edges are dropped.
+ */
+void Lattice::syncObjects(){
+	if(nodesOut){ //Nodes whose UID survives are kept, so outside references stay valid
+		std::unordered_map<unsigned int, std::shared_ptr<Node> > kept;
+		kept.reserve(2*this->vortices.size());
+		for(std::shared_ptr<Node> n : this->vortices){
+			n->getEdges().clear();
+			kept[n->getUid()] = n;
+		}
+		this->edges.clear();
+		this->vortices.clear();
+		this->vortices.reserve(nodeData.size());
+		for(unsigned int ii = 0; ii < nodeData.size(); ++ii){
+			std::unordered_map<unsigned int, std::shared_ptr<Node> >::iterator it = kept.find(nodeUid[ii]);
+			if(it != kept.end()){
+				it->second->setData(nodeData[ii]);
+				this->vortices.push_back(it->second);
+				continue;
+			}
+			std::shared_ptr<Node> n(new Node(nodeData[ii]));
+			n->uid = nodeUid[ii];
+			this->vortices.push_back(n);
+		}
+		nodesOut = false;
+		edgesOut = true;
+	}
+	if(edgesOut){
+		for(std::shared_ptr<Node> n : this->vortices)
+			n->getEdges().clear();
+		this->edges.clear();
+		this->edges.reserve(edgeA.size());
+		for(unsigned int k = 0; k < edgeA.size(); ++k){
+			std::shared_ptr<Edge> e(new Edge(this->vortices[edgeA[k]], this->vortices[edgeB[k]]));
+			e->setWeight(vortexDistance(nodeData[edgeA[k]], nodeData[edgeB[k]]));
+			this->edges.push_back(e);
+			this->vortices[edgeA[k]]->addEdge(e);
+			this->vortices[edgeB[k]]->addEdge(e);
+		}
+		edgesOut = false;
+	}
+}
+
+/***
+ * Called before handing out or modifying Node/Edge objects; the arena is
+ * rebuilt from them on its next use.
+ */
+void Lattice::touchObjects(){
+	syncObjects();
+	arenaOut = true;
+	csrOut = true;
+}
+
+void Lattice::indexUids(){
+	idxOfUid.clear();
+	idxOfUid.reserve(2*nodeUid.size());
+	for(unsigned int ii = 0; ii < nodeUid.size(); ++ii)
+		idxOfUid[nodeUid[ii]] = ii;
+}
+
+/***
+ * Copies the Node/Edge objects into the arena. Edges whose nodes are no
+ * longer in the lattice are dropped, as are the hull flags if the vortices
+ * changed places.
+ */
+void Lattice::syncArena(){
+	if(!arenaOut)
+		return;
+	bool moved = nodeUid.size() != this->vortices.size();
+	for(unsigned int ii = 0; ii < this->vortices.size() && !moved; ++ii)
+		moved = nodeUid[ii] != this->vortices[ii]->getUid();
+	if(moved)
+		nodeHull.clear();
+	nodeData.resize(this->vortices.size());
+	nodeUid.resize(this->vortices.size());
+	for(unsigned int ii = 0; ii < this->vortices.size(); ++ii){
+		nodeData[ii] = this->vortices[ii]->getData();
+		nodeUid[ii] = this->vortices[ii]->getUid();
+	}
+	indexUids();
+	edgeA.clear();
+	edgeB.clear();
+	for(std::shared_ptr<Edge> e : this->edges){
+		std::shared_ptr<Node> n1 = e->getVortex(0).lock(), n2 = e->getVortex(1).lock();
+		if(!n1 || !n2)
+			continue;
+		std::unordered_map<unsigned int, unsigned int>::iterator a = idxOfUid.find(n1->getUid()), b = idxOfUid.find(n2->getUid());
+		if(a == idxOfUid.end() || b == idxOfUid.end())
+			continue;
+		edgeA.push_back(a->second);
+		edgeB.push_back(b->second);
+	}
+	arenaOut = false;
+	csrOut = true;
+}
+
+/***
+ * Counting sort of the edge list into CSR, each edge entered from both ends.
+ */
+void Lattice::syncCSR(){
+	syncArena();
+	if(!csrOut)
+		return;
+	unsigned int n = nodeData.size();
+	rowPtr.assign(n + 1, 0);
+	for(unsigned int k = 0; k < edgeA.size(); ++k){
+		++rowPtr[edgeA[k] + 1];
+		++rowPtr[edgeB[k] + 1];
+	}
+	for(unsigned int ii = 0; ii < n; ++ii)
+		rowPtr[ii + 1] += rowPtr[ii];
+	colIdx.resize(rowPtr[n]);
+	colWeight.resize(rowPtr[n]);
+	std::vector<unsigned int> next(rowPtr.begin(), rowPtr.end() - 1);
+	for(unsigned int k = 0; k < edgeA.size(); ++k){
+		unsigned int a = edgeA[k], b = edgeB[k];
+		double d = vortexDistance(nodeData[a], nodeData[b]);
+		colIdx[next[a]] = b;
+		colWeight[next[a]++] = d;
+		colIdx[next[b]] = a;
+		colWeight[next[b]++] = d;
+	}
+	csrOut = false;
+}
+
+void Lattice::setVortices(const Vtx::Vortex *v, unsigned int num){
+	nodeData.assign(v, v + num);
+	nodeUid.resize(num);
+	for(unsigned int ii = 0; ii < num; ++ii)
+		nodeUid[ii] = v[ii].uid + 1;
+	indexUids();
+	edgeA.clear();
+	edgeB.clear();
+	nodeHull.clear();
+	arenaOut = false;
+	nodesOut = true;
+	csrOut = true;
+}
+
+/***
+ * As setVortices() followed by createEdgesDelaunay(), but the triangulation
+ * of the previous call is updated rather than rebuilt, by vortex UID.
+ */
+void Lattice::updateVortices(const Vtx::Vortex *v, unsigned int num){
+	setVortices(v, num);
+	dt.update(v, num);
+	edgeA = dt.getEdgeA();
+	edgeB = dt.getEdgeB();
+	nodeHull = dt.getHull();
+}
+
+void Lattice::clear(){
+	setVortices(NULL, 0);
+}
+
+unsigned int Lattice::getNumVortices(){
+	return arenaOut ? this->vortices.size() : nodeData.size();
+}
+
+unsigned int Lattice::getNumEdges(){
+	return arenaOut ? this->edges.size() : edgeA.size();
+}
+
+const Vtx::Vortex &Lattice::getVortexData(unsigned int idx){
+	syncArena();
+	return nodeData.at(idx);
+}
+
+unsigned int Lattice::getUidIdx(unsigned int idx){
+	syncArena();
+	return nodeUid.at(idx);
+}
+
+const std::vector<unsigned int> &Lattice::getRowPtr(){
+	syncCSR();
+	return rowPtr;
+}
+
+const std::vector<unsigned int> &Lattice::getColIdx(){
+	syncCSR();
+	return colIdx;
+}
+
+const std::vector<double> &Lattice::getColWeight(){
+	syncCSR();
+	return colWeight;
+}
+
+unsigned int Lattice::getCoordination(unsigned int idx){
+	syncCSR();
+	return rowPtr.at(idx + 1) - rowPtr.at(idx);
+}
+
+bool Lattice::isOnHull(unsigned int idx){
+	return idx < nodeHull.size() && nodeHull[idx];
+}
+
+void Lattice::getVoronoi(double *area, unsigned int *sides){
+	syncArena();
+	if(nodeHull.size() != nodeData.size() || dt.getHull().size() != nodeData.size()){
+		for(unsigned int ii = 0; ii < nodeData.size(); ++ii){
+			area[ii] = 0.0;
+			sides[ii] = 0;
+		}
+		return;
+	}
+	dt.voronoi(area, sides);
+}
+
+unsigned int Lattice::countDefects(unsigned int *count){
+	syncCSR();
+	unsigned int defects = 0;
+	for(int c = 0; c < 10; ++c)
+		count[c] = 0;
+	for(unsigned int ii = 0; ii + 1 < rowPtr.size(); ++ii){
+		if(isOnHull(ii))
+			continue;
+		unsigned int z = rowPtr[ii + 1] - rowPtr[ii];
+		++count[std::min(z, 9u)];
+		if(z != 6)
+			++defects;
+	}
+	return defects;
 }
 
 //######################################################################################################################
@@ -55,6 +296,7 @@ Lattice::~Lattice(){
 //######################################################################################################################
 
 std::vector< std::shared_ptr<Node> >& Lattice::getVortices(){
+	this->touchObjects();
 	return this->vortices;
 }
 
@@ -63,25 +305,31 @@ std::shared_ptr<Node> Lattice::getVortexIdx(unsigned int idx){
 }
 
 /***
- * Gets the location of the Node with UID uid.
+ * Gets the location of the Node with UID uid through the UID hash. While the
+ * Node objects are authoritative they may have been reordered through
+ * getVortices(), so a hit is checked and the hash rebuilt on a mismatch.
  */
 unsigned int Lattice::getVortexIdxUid(unsigned int uid){
-	for (int ii=0; ii< getVortices().size(); ++ii){
-		if(this->Lattice::getVortexIdx(ii)->getUid()== uid){
-			return ii;
-		}
-	}
-	return -1;
+	std::unordered_map<unsigned int, unsigned int>::iterator it = idxOfUid.find(uid);
+	if(!arenaOut)
+		return (it == idxOfUid.end()) ? -1 : it->second;
+	if(it != idxOfUid.end() && it->second < this->vortices.size() && this->vortices[it->second]->getUid() == uid)
+		return it->second;
+	idxOfUid.clear();
+	for(unsigned int ii = 0; ii < this->vortices.size(); ++ii)
+		idxOfUid[this->vortices[ii]->getUid()] = ii;
+	it = idxOfUid.find(uid);
+	return (it == idxOfUid.end()) ? -1 : it->second;
 }
 
 /***
- * Gets the the Node with UID uid. Assumes Node exists.
+ * Gets the the Node with UID uid. Empty if it does not exist.
  */
 std::shared_ptr<Node> Lattice::getVortexUid(unsigned int uid){
-	for (std::shared_ptr<Node> n : this->Lattice::getVortices()){
-		if(n->getUid()== uid){
-			return n;
-		}
+	this->touchObjects();
+	unsigned int idx = this->getVortexIdxUid(uid);
+	if(idx < this->vortices.size()){
+		return this->vortices[idx];
 	}
 	return std::shared_ptr<Node>();
 }
@@ -125,6 +373,7 @@ std::shared_ptr<Edge> Lattice::getEdgeUid(unsigned int uid){
 }
 
 std::vector< std::shared_ptr<Edge> >& Lattice::getEdges(){
+	this->touchObjects();
 	return this->edges;
 }
 
@@ -146,36 +395,79 @@ void Lattice::setEdge(unsigned int idx, std::shared_ptr<Edge> e){
 
 
 void Lattice::createEdges(unsigned int radius){
-	std::shared_ptr<Edge> e;
-	double dist = 0.0;
-	for(int ii=0; ii< this->Lattice::getVortices().size(); ++ii){
-		//std::cout << "Got here ii " << ii << std::endl;
-		for(int jj=ii+1; jj < this->Lattice::getVortices().size(); ++jj){
-			dist = Lattice::getVortexDistance(this->getVortexIdx(ii),this->getVortexIdx(jj));
-			if(dist < radius ) {
-				//std::cout << "Got here jj " << jj << std::endl;
-				e.reset(new Edge ( this->getVortexIdx(ii), this->getVortexIdx(jj) ));
-				e->setWeight(dist);
-				this->Lattice::addEdge(e,this->getVortexIdx(ii),this->getVortexIdx(jj));
-			}
-		}
-	}
+	this->Lattice::createEdges((double) radius);
 }
+
+/***
+ * Adds an edge between every pair of vortices closer than radius, in the
+ * arena only. Edge objects are made if and when they are asked for.
+ * Vortices are binned into square cells at least radius wide, so each one is
+ * only compared against the 3x3 cells around it, on squared distances. Rows
+ * run in parallel into per-thread lists that are appended in row order, so
+ * the edges come out in the same order as an all-pairs search.
+ */
 void Lattice::createEdges(double radius){
-	std::shared_ptr<Edge> e;
-	double dist = 0.0;
-	for(int ii=0; ii< this->Lattice::getVortices().size(); ++ii){
-		//std::cout << "Got here ii " << ii << std::endl;
-		for(int jj=ii+1; jj < this->Lattice::getVortices().size(); ++jj){
-			dist = Lattice::getVortexDistance(this->getVortexIdx(ii),this->getVortexIdx(jj));
-			if( dist < radius ) {
-				//std::cout << "Got here jj " << jj << std::endl;
-				e.reset(new Edge ( this->getVortexIdx(ii), this->getVortexIdx(jj) ));
-				e->setWeight(dist);
-				this->Lattice::addEdge(e,this->getVortexIdx(ii),this->getVortexIdx(jj));
+	this->syncArena();
+	unsigned int n = nodeData.size();
+	if(n < 2 || radius <= 0.0)
+		return;
+	std::vector<double2> pos(n);
+	for(unsigned int ii = 0; ii < n; ++ii){
+		pos[ii].x = nodeData[ii].coords.x;
+		pos[ii].y = nodeData[ii].coords.y;
+	}
+	PairCorr::CellList cells;
+	cells.build(pos.data(), n, radius);
+
+	double r2 = radius*radius;
+	int nThreads = 1;
+	#ifdef _OPENMP
+	nThreads = omp_get_max_threads();
+	#endif
+	std::vector< std::vector<unsigned int> > hitA(nThreads), hitB(nThreads);
+	#pragma omp parallel num_threads(nThreads)
+	{
+		int t = 0;
+		#ifdef _OPENMP
+		t = omp_get_thread_num();
+		#endif
+		std::vector<unsigned int> row;
+		#pragma omp for schedule(static)
+		for(int ii = 0; ii < (int) n; ++ii){
+			row.clear();
+			cells.neighbours(ii, [&](int jj){
+				double dx = pos[ii].x - pos[jj].x, dy = pos[ii].y - pos[jj].y;
+				if(dx*dx + dy*dy < r2)
+					row.push_back(jj);
+			});
+			std::sort(row.begin(), row.end());
+			for(unsigned int jj : row){
+				hitA[t].push_back(ii);
+				hitB[t].push_back(jj);
 			}
 		}
 	}
+	for(int t = 0; t < nThreads; ++t){
+		edgeA.insert(edgeA.end(), hitA[t].begin(), hitA[t].end());
+		edgeB.insert(edgeB.end(), hitB[t].begin(), hitB[t].end());
+	}
+	edgesOut = true;
+	csrOut = true;
+}
+
+/***
+ * Edges of the Delaunay triangulation on coordsD. Unlike a distance cutoff
+ * this needs no knowledge of the lattice spacing, and gives every interior
+ * vortex of a perfect lattice six neighbours.
+ */
+void Lattice::createEdgesDelaunay(){
+	this->syncArena();
+	dt.triangulate(nodeData.data(), nodeData.size());
+	edgeA = dt.getEdgeA();
+	edgeB = dt.getEdgeB();
+	nodeHull = dt.getHull();
+	edgesOut = true;
+	csrOut = true;
 }
 
 void Lattice::addVortex(std::shared_ptr<Node> n){
@@ -289,34 +581,24 @@ void Lattice::destroyVortex(unsigned int uid){
 //######################################################################################################################
 
 /**
- * Create adjacency matrix
+ * Create adjacency matrix from the CSR rows
  */
 void Lattice::genAdjMat(unsigned int *mat){
-	int idx1, idx2, idx;
-	idx1 = 0; idx2 = 0; idx=0;
-	for(std::shared_ptr<Node> n : this->Lattice::getVortices()){
-		idx1=this->getVortexIdxUid(n->getUid());
-		for(std::weak_ptr<Edge> e : n->getEdges()){
-			idx2 = this->getVortexIdxUid(n->getConnectedNode(e.lock())->getUid());
-			//std::cout << "this=" << n->getUid() << "   connected=" << n->getConnectedNode(e.lock())->getUid() << std::endl;
-			idx = idx1*this->Lattice::getVortices().size() + idx2;
-			//std::cout << "idx1=" << idx1 << "   idx2=" << idx2 << " idx=" << idx << "\n" << std::endl;
-			mat[idx] = 1;
+	this->syncCSR();
+	size_t n = nodeData.size();
+	for(size_t ii = 0; ii < n; ++ii){
+		for(unsigned int k = rowPtr[ii]; k < rowPtr[ii+1]; ++k){
+			mat[ii*n + colIdx[k]] = 1;
 		}
 	}
 }
 
 void Lattice::genAdjMat(double *mat){
-	int idx1, idx2, idx;
-	idx1 = 0; idx2 = 0; idx=0;
-	for(std::shared_ptr<Node> n : this->Lattice::getVortices()){
-		idx1=this->getVortexIdxUid(n->getUid());
-		for(std::weak_ptr<Edge> e : n->getEdges()){
-			idx2 = this->getVortexIdxUid(n->getConnectedNode(e.lock())->getUid());
-			//std::cout << "this=" << n->getUid() << "   connected=" << n->getConnectedNode(e.lock())->getUid() << std::endl;
-			idx = idx1*this->Lattice::getVortices().size() + idx2;
-			//std::cout << "idx1=" << idx1 << "   idx2=" << idx2 << " idx=" << idx << "\n" << std::endl;
-			mat[idx] = this->Lattice::getVortexDistance(n, this->getVortexIdx(idx2));
+	this->syncCSR();
+	size_t n = nodeData.size();
+	for(size_t ii = 0; ii < n; ++ii){
+		for(unsigned int k = rowPtr[ii]; k < rowPtr[ii+1]; ++k){
+			mat[ii*n + colIdx[k]] = colWeight[k];
 		}
 	}
 }
@@ -326,7 +608,7 @@ void Lattice::genAdjMat(double *mat){
  * Outputs adjacency matrix in format for copy/paste into Mathematica.
  */
 void Lattice::adjMatMtca(unsigned int *mat){
-	unsigned int size = this->Lattice::getVortices().size();
+	unsigned int size = this->Lattice::getNumVortices();
 	std::cout << "{";
 	for(int ii = 0; ii < size; ++ii){
 		std::cout << "{";
@@ -344,7 +626,7 @@ void Lattice::adjMatMtca(unsigned int *mat){
 	std::cout << "}" << std::endl;
 }
 void Lattice::adjMatMtca(double *mat){
-	unsigned int size = this->Lattice::getVortices().size();
+	unsigned int size = this->Lattice::getNumVortices();
 	std::cout << "{";
 	for(int ii = 0; ii < size; ++ii){
 		std::cout << "{";
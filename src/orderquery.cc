@@ -0,0 +1,93 @@
+/*** orderquery.cc - GPUE: Split Operator based GPU solver for Nonlinear
+Schrodinger Equation, Copyright (C) 2011-2015, Lee J. O'Riordan
+<loriordan@gmail.com>, Tadhg Morgan, Neil Crowley.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Orientational order and Voronoi statistics of stored vortex files.
+ *
+ * gpue_order rMax bins vort_arr_<step> [vort_arr_<step> ...]
+ *
+ * For each file writes vort_psi6_<step> and vort_g6_<step>, and a row of
+ * vort_order, as evolve() does in-process with --order. vort_order is
+ * started afresh on each invocation.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "../include/fileIO.h"
+#include "../include/hexatic.h"
+
+unsigned int LatticeGraph::Edge::suid = 0;
+unsigned int LatticeGraph::Node::suid = 0;
+
+int main(int argc, char **argv){
+	if(argc < 4){
+		fprintf(stderr,"Usage: %s rMax bins vort_arr_<step> [vort_arr_<step> ...]\n",argv[0]);
+		return 1;
+	}
+	double rMax = atof(argv[1]);
+	int bins = atoi(argv[2]);
+	char buffer[256];
+	LatticeGraph::Lattice lattice;
+	std::vector<double2> psi;
+	std::vector<double> area, g6(bins > 0 ? bins : 0), pairs(bins > 0 ? bins : 0);
+	std::vector<unsigned int> sides;
+	for(int a = 3; a < argc; ++a){
+		int num;
+		struct Vtx::Vortex *v = FileIO::readVortexUid(argv[a], &num);
+		if(v == NULL){
+			fprintf(stderr,"Cannot read %s\n",argv[a]);
+			continue;
+		}
+		const char *us = strrchr(argv[a], '_');
+		int step = us ? atoi(us + 1) : a - 3;
+		lattice.setVortices(v, num);
+		lattice.createEdgesDelaunay();
+		psi.resize(num);
+		area.resize(num);
+		sides.resize(num);
+		Hexatic::psi6(lattice, psi.data());
+		lattice.getVoronoi(area.data(), sides.data());
+		Hexatic::Summary s = Hexatic::summarise(lattice, psi.data(), area.data(), sides.data());
+		Hexatic::writeSummary("vort_order", step, s, -1);
+		FileIO::writeOutOrder(buffer, "vort_psi6", v, psi.data(), area.data(), sides.data(), num, step);
+		if(bins > 0){
+			Hexatic::g6(v, psi.data(), num, rMax, bins, g6.data(), pairs.data());
+			FileIO::writeOutG6(buffer, "vort_g6", rMax, bins, g6.data(), pairs.data(), step);
+		}
+		printf("%s: %d vortices, <|psi6|>=%f, |<psi6>|=%f\n", argv[a], s.num, s.psi6Mean, s.psi6Global);
+		free(v);
+	}
+	return 0;
+}
@@ -0,0 +1,145 @@
+/*** paircorr.cc - GPUE: Split Operator based GPU solver for Nonlinear
+Schrodinger Equation, Copyright (C) 2011-2015, Lee J. O'Riordan
+<loriordan@gmail.com>, Tadhg Morgan, Neil Crowley.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../include/paircorr.h"
+
+namespace PairCorr {
+
+	void CellList::build(const double2 *pos, int num, double radius){
+		cx = cy = 1;
+		start.assign(2, 0);
+		cellOf.assign(num, 0);
+		sorted.resize(num);
+		if(num < 1)
+			return;
+		double x0 = pos[0].x, x1 = x0, y0 = pos[0].y, y1 = y0;
+		for(int ii = 1; ii < num; ++ii){
+			x0 = std::min(x0, pos[ii].x); x1 = std::max(x1, pos[ii].x);
+			y0 = std::min(y0, pos[ii].y); y1 = std::max(y1, pos[ii].y);
+		}
+		double cell = std::max(radius, sqrt((x1 - x0 + 1.0)*(y1 - y0 + 1.0)/(4.0*num)));
+		cx = (int)((x1 - x0)/cell) + 1;
+		cy = (int)((y1 - y0)/cell) + 1;
+		start.assign(cx*cy + 1, 0);
+		for(int ii = 0; ii < num; ++ii){
+			cellOf[ii] = (int)((pos[ii].x - x0)/cell)*cy + (int)((pos[ii].y - y0)/cell);
+			++start[cellOf[ii] + 1];
+		}
+		for(int c = 0; c < cx*cy; ++c)
+			start[c + 1] += start[c];
+		std::vector<int> next(start.begin(), start.end() - 1);
+		for(int ii = 0; ii < num; ++ii)
+			sorted[next[cellOf[ii]]++] = ii;
+	}
+
+//######################################################################################################################
+
+	void histogram(const double2 *pos, int num, double rMax, int bins, double *count, const double2 *w, double *wsum){
+		bool weighted = (w != NULL && wsum != NULL);
+		for(int b = 0; b < bins; ++b){
+			count[b] = 0.0;
+			if(weighted)
+				wsum[b] = 0.0;
+		}
+		if(num < 2 || rMax <= 0.0 || bins <= 0)
+			return;
+		CellList cells;
+		cells.build(pos, num, rMax);
+
+		int nThreads = 1;
+		#ifdef _OPENMP
+		nThreads = std::max(1, std::min(omp_get_max_threads(), num/256));
+		#endif
+		std::vector<double> cnt((size_t) nThreads*bins, 0.0), sum(weighted ? (size_t) nThreads*bins : 0, 0.0);
+		double scale = bins/rMax, r2Max = rMax*rMax;
+		#pragma omp parallel num_threads(nThreads)
+		{
+			int t = 0;
+			#ifdef _OPENMP
+			t = omp_get_thread_num();
+			#endif
+			double *c = &cnt[(size_t) t*bins], *s = weighted ? &sum[(size_t) t*bins] : NULL;
+			#pragma omp for schedule(dynamic,64)
+			for(int ii = 0; ii < num; ++ii){
+				cells.neighbours(ii, [&](int jj){
+					double dx = pos[ii].x - pos[jj].x, dy = pos[ii].y - pos[jj].y;
+					double r2 = dx*dx + dy*dy;
+					if(r2 >= r2Max)
+						return;
+					int bin = std::min((int)(sqrt(r2)*scale), bins - 1);
+					c[bin] += 1.0;
+					if(weighted)
+						s[bin] += w[ii].x*w[jj].x + w[ii].y*w[jj].y;
+				});
+			}
+		}
+		for(int t = 0; t < nThreads; ++t){
+			for(int b = 0; b < bins; ++b){
+				count[b] += cnt[(size_t) t*bins + b];
+				if(weighted)
+					wsum[b] += sum[(size_t) t*bins + b];
+			}
+		}
+	}
+
+	/*
+	 * An ideal gas of num points in area puts num(num-1)/2 * shell/area
+	 * pairs in each shell. No edge correction is made, so g(r) falls below
+	 * 1 as r approaches the size of the cloud.
+	 */
+	void normalise(const double *count, int num, double area, double rMax, int bins, double *g){
+		double pairs = 0.5*num*(num - 1.0), dr = rMax/bins;
+		for(int b = 0; b < bins; ++b){
+			double shell = M_PI*dr*dr*(2.0*b + 1.0);
+			g[b] = (pairs > 0.0 && area > 0.0) ? count[b]*area/(pairs*shell) : 0.0;
+		}
+	}
+
+	double boundingArea(const double2 *pos, int num){
+		if(num < 2)
+			return 0.0;
+		double x0 = pos[0].x, x1 = x0, y0 = pos[0].y, y1 = y0;
+		for(int ii = 1; ii < num; ++ii){
+			x0 = std::min(x0, pos[ii].x); x1 = std::max(x1, pos[ii].x);
+			y0 = std::min(y0, pos[ii].y); y1 = std::max(y1, pos[ii].y);
+		}
+		return (x1 - x0)*(y1 - y0);
+	}
+}
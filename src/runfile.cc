@@ -0,0 +1,244 @@
+/*** runfile.cc - GPUE: Split Operator based GPU solver for Nonlinear
+Schrodinger Equation, Copyright (C) 2011-2015, Lee J. O'Riordan
+<loriordan@gmail.com>, Tadhg Morgan, Neil Crowley.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <set>
+#include <string>
+#include "../include/runfile.h"
+
+namespace RunFile {
+
+	static std::set<std::string> started; //Containers this process has appended to
+
+	/*
+	 * Length of one frame of a container.
+	 */
+	static size_t frameBytes(const RunHeader &h){
+		size_t tiles = (size_t) ((h.xDim + h.tile - 1)/h.tile)*((h.yDim + h.tile - 1)/h.tile);
+		return sizeof(FrameHeader) + sizeof(double2)*h.tile*h.tile*tiles;
+	}
+
+	/*
+	 * Writes the snapshot as tiles. A new container gets its header first;
+	 * an existing one must hold the same grid, and keeps its own tile size.
+	 * On the first append of a run, the frames kept from an earlier run are
+	 * those before fromStep and in step order, so findFrame() stays valid.
+	 * The body must otherwise be a whole number of frames.
+	 */
+	int appendFrame(char *file, double2 *data, int xDim, int yDim, int tile, int step, int fromStep){
+		RunHeader h;
+		bool first = started.insert(file).second;
+		FILE *f = (first && fromStep < 0) ? NULL : fopen(file,"rb+");
+		if(f != NULL){
+			if(fread(&h, sizeof(RunHeader), 1, f) != 1 || strncmp(h.magic,"GPUR",4) != 0 || h.version != 1
+			   || h.elemSize != sizeof(double2) || h.tile < 1 || h.xDim != xDim || h.yDim != yDim){
+				fprintf(stderr,"%s does not hold a %dx%d run\n",file,xDim,yDim);
+				fclose(f);
+				return -1;
+			}
+			fseeko(f, 0, SEEK_END);
+			long long body = ftello(f) - (long long) sizeof(RunHeader), len = frameBytes(h);
+			if(first){
+				long long keep = 0, last = -1;
+				FrameHeader fh;
+				for(; keep + len <= body; keep += len){
+					if(fseeko(f, sizeof(RunHeader) + keep, SEEK_SET) != 0 || fread(&fh, sizeof(FrameHeader), 1, f) != 1
+					   || fh.step >= fromStep || fh.step < last)
+						break;
+					last = fh.step;
+				}
+				fflush(f);
+				if(ftruncate(fileno(f), sizeof(RunHeader) + keep) != 0){
+					fprintf(stderr,"Cannot truncate %s\n",file);
+					fclose(f);
+					return -1;
+				}
+				body = keep;
+			}
+			if(body % len != 0){
+				fprintf(stderr,"%s ends in a partial frame\n",file);
+				fclose(f);
+				return -1;
+			}
+			fseeko(f, sizeof(RunHeader) + body, SEEK_SET);
+		}
+		else{
+			f = fopen(file,"wb");
+			if(f == NULL){
+				fprintf(stderr,"Cannot create %s\n",file);
+				return -1;
+			}
+			memcpy(h.magic,"GPUR",4);
+			h.version = 1;
+			h.xDim = xDim;
+			h.yDim = yDim;
+			h.tile = (tile < 1) ? 64 : tile;
+			h.elemSize = sizeof(double2);
+			fwrite(&h, sizeof(RunHeader), 1, f);
+		}
+		int T = h.tile;
+		int tilesX = (xDim + T - 1)/T, tilesY = (yDim + T - 1)/T;
+		FrameHeader fh;
+		fh.step = step;
+		fh.reserved = 0;
+		fwrite(&fh, sizeof(FrameHeader), 1, f);
+
+		double2 *buf = (double2*) malloc(sizeof(double2)*T*T);
+		for(int ti = 0; ti < tilesX; ++ti){
+			for(int tj = 0; tj < tilesY; ++tj){
+				memset(buf, 0, sizeof(double2)*T*T);
+				int ni = (ti*T + T > xDim) ? xDim - ti*T : T;
+				int nj = (tj*T + T > yDim) ? yDim - tj*T : T;
+				for(int a = 0; a < ni; ++a)
+					memcpy(&buf[a*T], &data[(ti*T + a)*yDim + tj*T], sizeof(double2)*nj);
+				fwrite(buf, sizeof(double2), T*T, f);
+			}
+		}
+		free(buf);
+		if(fclose(f) != 0){
+			fprintf(stderr,"Cannot write %s\n",file);
+			return -1;
+		}
+		return 0;
+	}
+
+//######################################################################################################################
+
+	Reader::Reader(char *file) : map(NULL), mapLen(0), tilesX(0), tilesY(0), frameLen(0), frames(0){
+		int fd = open(file, O_RDONLY);
+		if(fd < 0)
+			return;
+		struct stat st;
+		if(fstat(fd,&st) != 0 || (size_t) st.st_size < sizeof(RunHeader)){
+			close(fd);
+			return;
+		}
+		void *m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if(m == MAP_FAILED)
+			return;
+		memcpy(&h, m, sizeof(RunHeader));
+		if(strncmp(h.magic,"GPUR",4) != 0 || h.version != 1 || h.elemSize != sizeof(double2) || h.tile < 1){
+			munmap(m, st.st_size);
+			return;
+		}
+		frameLen = frameBytes(h);
+		if((st.st_size - sizeof(RunHeader)) % frameLen != 0){
+			fprintf(stderr,"%s ends in a partial frame\n",file);
+			munmap(m, st.st_size);
+			return;
+		}
+		map = (char*) m;
+		mapLen = st.st_size;
+		madvise(map, mapLen, MADV_RANDOM); //Queries touch scattered tiles; avoid read-ahead
+		tilesX = (h.xDim + h.tile - 1)/h.tile;
+		tilesY = (h.yDim + h.tile - 1)/h.tile;
+		frames = (mapLen - sizeof(RunHeader))/frameLen;
+	}
+
+	Reader::~Reader(){
+		if(map != NULL)
+			munmap(map, mapLen);
+	}
+
+	bool Reader::isOpen(){
+		return map != NULL;
+	}
+
+	int2 Reader::getDims(){
+		int2 d;
+		d.x = h.xDim;
+		d.y = h.yDim;
+		return d;
+	}
+
+	int Reader::getFrames(){
+		return frames;
+	}
+
+	long long Reader::getStep(int frame){
+		FrameHeader fh;
+		memcpy(&fh, map + sizeof(RunHeader) + frame*frameLen, sizeof(FrameHeader));
+		return fh.step;
+	}
+
+	/*
+	 * Binary search over the frame headers; touches log2(frames) pages.
+	 */
+	int Reader::findFrame(long long step){
+		int lo = 0, hi = frames;
+		while(lo < hi){
+			int mid = (lo + hi)/2;
+			if(getStep(mid) < step)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		return lo;
+	}
+
+	double2 *Reader::tileAt(int frame, int ti, int tj){
+		return (double2*) (map + sizeof(RunHeader) + frame*frameLen + sizeof(FrameHeader)
+		                   + sizeof(double2)*h.tile*h.tile*(ti*tilesY + tj));
+	}
+
+	double2 Reader::readPoint(int frame, int i, int j){
+		double2 v;
+		memcpy(&v, tileAt(frame, i/h.tile, j/h.tile) + (i%h.tile)*h.tile + j%h.tile, sizeof(double2));
+		return v;
+	}
+
+	int Reader::readRegion(int frame, int x0, int y0, int nx, int ny, double2 *out){
+		if(x0 < 0 || y0 < 0 || nx < 1 || ny < 1 || x0 + nx > h.xDim || y0 + ny > h.yDim)
+			return -1;
+		int T = h.tile;
+		for(int ti = x0/T; ti <= (x0 + nx - 1)/T; ++ti){
+			for(int tj = y0/T; tj <= (y0 + ny - 1)/T; ++tj){
+				double2 *t = tileAt(frame, ti, tj);
+				int a0 = (ti*T > x0) ? ti*T : x0;
+				int a1 = (ti*T + T < x0 + nx) ? ti*T + T : x0 + nx;
+				int b0 = (tj*T > y0) ? tj*T : y0;
+				int b1 = (tj*T + T < y0 + ny) ? tj*T + T : y0 + ny;
+				for(int a = a0; a < a1; ++a)
+					memcpy(&out[(a - x0)*ny + (b0 - y0)], &t[(a - ti*T)*T + (b0 - tj*T)], sizeof(double2)*(b1 - b0));
+			}
+		}
+		return 0;
+	}
+}
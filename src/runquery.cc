@@ -0,0 +1,188 @@
+/*** runquery.cc - GPUE: Split Operator based GPU solver for Nonlinear
+Schrodinger Equation, Copyright (C) 2011-2015, Lee J. O'Riordan
+<loriordan@gmail.com>, Tadhg Morgan, Neil Crowley.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Extracts points or rectangles from a run container over a range of steps.
+ *
+ * gpue_query file list
+ * gpue_query file point i j [step0 step1]
+ * gpue_query file roi x0 y0 nx ny [step0 step1]
+ * gpue_query file traj [uid]
+ * gpue_query file gr rMax bins [area]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include "../include/runfile.h"
+#include "../include/trajfile.h"
+#include "../include/paircorr.h"
+
+/*
+ * Streams the trajectory file once, in block order. Blocks are written in
+ * step order, so the samples of a step are complete once the next block
+ * starts at a later step, and only the steps straddling a block boundary
+ * are held in memory.
+ */
+static int pairCorrelation(TrajFile::Reader &t, double rMax, int bins, double area){
+	std::vector<TrajFile::Record> recs;
+	std::vector<double2> pos;
+	std::vector<double> g(bins);
+	printf("#STEP,VORTICES");
+	for(int b = 0; b < bins; ++b)
+		printf(",%e", (b + 0.5)*rMax/bins);
+	printf("\n");
+	for(int blk = 0; blk < t.getBlocks(); ++blk){
+		if(t.getBlock(blk, recs) != 0)
+			return -1;
+		std::stable_sort(recs.begin(), recs.end(), [](const TrajFile::Record &a, const TrajFile::Record &b){ return a.step < b.step; });
+		int done = t.getStepMin(blk + 1);
+		size_t k = 0;
+		while(k < recs.size() && recs[k].step < done){
+			size_t k1 = k;
+			pos.clear();
+			for(; k1 < recs.size() && recs[k1].step == recs[k].step; ++k1)
+				pos.push_back(make_double2(recs[k1].x, recs[k1].y));
+			int num = pos.size();
+			PairCorr::histogram(pos.data(), num, rMax, bins, g.data());
+			PairCorr::normalise(g.data(), num, (area > 0.0) ? area : PairCorr::boundingArea(pos.data(), num), rMax, bins, g.data());
+			printf("%d,%d", recs[k].step, num);
+			for(int b = 0; b < bins; ++b)
+				printf(",%e", g[b]);
+			printf("\n");
+			k = k1;
+		}
+		recs.erase(recs.begin(), recs.begin() + k);
+	}
+	return 0;
+}
+
+int main(int argc, char **argv){
+	if(argc < 3){
+		fprintf(stderr,"Usage: %s file list | point i j [step0 step1] | roi x0 y0 nx ny [step0 step1] | traj [uid] | gr rMax bins [area]\n",argv[0]);
+		return 1;
+	}
+	if(strcmp(argv[2],"traj") == 0){
+		TrajFile::Reader t(argv[1]);
+		if(!t.isOpen()){
+			fprintf(stderr,"%s is not a GPUE trajectory file\n",argv[1]);
+			return 1;
+		}
+		std::vector<TrajFile::Record> recs;
+		int n = (argc >= 4) ? t.getTrajectory(strtoul(argv[3], NULL, 10), recs) : t.getAll(recs);
+		if(n < 0){
+			fprintf(stderr,"Cannot read %s\n",argv[1]);
+			return 1;
+		}
+		printf("#UID,STEP,X,Y,WINDING\n");
+		for(int k = 0; k < n; ++k)
+			printf("%u,%d,%.8e,%.8e,%d\n", recs[k].uid, recs[k].step, recs[k].x, recs[k].y, recs[k].wind);
+		return 0;
+	}
+	if(strcmp(argv[2],"gr") == 0){
+		if(argc < 5){
+			fprintf(stderr,"Usage: %s file gr rMax bins [area]\n",argv[0]);
+			return 1;
+		}
+		double rMax = atof(argv[3]), area = (argc >= 6) ? atof(argv[5]) : 0.0;
+		int bins = atoi(argv[4]);
+		if(rMax <= 0.0 || bins < 1){
+			fprintf(stderr,"g(r) needs rMax > 0 and at least one bin\n");
+			return 1;
+		}
+		TrajFile::Reader t(argv[1]);
+		if(!t.isOpen()){
+			fprintf(stderr,"%s is not a GPUE trajectory file\n",argv[1]);
+			return 1;
+		}
+		if(pairCorrelation(t, rMax, bins, area) != 0){
+			fprintf(stderr,"Cannot read %s\n",argv[1]);
+			return 1;
+		}
+		return 0;
+	}
+	RunFile::Reader r(argv[1]);
+	if(!r.isOpen()){
+		fprintf(stderr,"%s is not a GPUE run container\n",argv[1]);
+		return 1;
+	}
+	int2 dims = r.getDims();
+	int nArgs = strcmp(argv[2],"point") == 0 ? 2 : strcmp(argv[2],"roi") == 0 ? 4 : 0;
+	long long s0 = 0, s1 = -1;
+	if(argc >= 3 + nArgs + 2){
+		s0 = atoll(argv[3 + nArgs]);
+		s1 = atoll(argv[4 + nArgs]);
+	}
+	int f0 = r.findFrame(s0);
+	int f1 = (s1 < 0) ? r.getFrames() : r.findFrame(s1 + 1);
+
+	if(strcmp(argv[2],"list") == 0){
+		printf("#%dx%d, %d frames\n", dims.x, dims.y, r.getFrames());
+		for(int f = 0; f < r.getFrames(); ++f)
+			printf("%lld\n", r.getStep(f));
+	}
+	else if(nArgs == 2 && argc >= 5){
+		int i = atoi(argv[3]), j = atoi(argv[4]);
+		if(i < 0 || j < 0 || i >= dims.x || j >= dims.y){
+			fprintf(stderr,"Point (%d,%d) outside %dx%d grid\n",i,j,dims.x,dims.y);
+			return 1;
+		}
+		printf("#STEP,RE,IM\n");
+		for(int f = f0; f < f1; ++f){
+			double2 v = r.readPoint(f, i, j);
+			printf("%lld,%.16e,%.16e\n", r.getStep(f), v.x, v.y);
+		}
+	}
+	else if(nArgs == 4 && argc >= 7){
+		int x0 = atoi(argv[3]), y0 = atoi(argv[4]), nx = atoi(argv[5]), ny = atoi(argv[6]);
+		double2 *out = (double2*) malloc(sizeof(double2)*nx*ny);
+		printf("#STEP,X,Y,RE,IM\n");
+		for(int f = f0; f < f1; ++f){
+			if(r.readRegion(f, x0, y0, nx, ny, out) != 0){
+				fprintf(stderr,"Region outside %dx%d grid\n",dims.x,dims.y);
+				free(out);
+				return 1;
+			}
+			for(int a = 0; a < nx; ++a)
+				for(int b = 0; b < ny; ++b)
+					printf("%lld,%d,%d,%.16e,%.16e\n", r.getStep(f), x0 + a, y0 + b, out[a*ny + b].x, out[a*ny + b].y);
+		}
+		free(out);
+	}
+	else{
+		fprintf(stderr,"Unknown query %s\n",argv[2]);
+		return 1;
+	}
+	return 0;
+}
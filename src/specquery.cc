@@ -0,0 +1,146 @@
+/*** specquery.cc - GPUE: Split Operator based GPU solver for Nonlinear
+Schrodinger Equation, Copyright (C) 2011-2015, Lee J. O'Riordan
+<loriordan@gmail.com>, Tadhg Morgan, Neil Crowley.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * Kinetic energy spectra, the density structure factor or the flow fields
+ * of the frames of a run container.
+ *
+ * gpue_spectrum file kinetic dx dy mass [bins [step0 step1]]
+ * gpue_spectrum file structure dx dy atoms [bins [step0 step1]]
+ * gpue_spectrum file flow dx dy mass [stride [step0 step1]]
+ *
+ * Writes ekc and eki, sk and the sk_mean, sk_var and sk_profile moments, or
+ * flow_<step>, as evolve() does in-process with --spectrum, --structure
+ * and --flow. The next frame is decoded on the host while the device works
+ * on the current one.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "../include/fileIO.h"
+#include "../include/runfile.h"
+#include "../include/spectrum.h"
+#include "../include/flow.h"
+
+int main(int argc, char **argv){
+	if(argc < 6 || (strcmp(argv[2],"kinetic") != 0 && strcmp(argv[2],"structure") != 0 && strcmp(argv[2],"flow") != 0)){
+		fprintf(stderr,"Usage: %s file kinetic dx dy mass | structure dx dy atoms [bins [step0 step1]] | flow dx dy mass [stride [step0 step1]]\n",argv[0]);
+		return 1;
+	}
+	RunFile::Reader r(argv[1]);
+	if(!r.isOpen()){
+		fprintf(stderr,"%s is not a GPUE run container\n",argv[1]);
+		return 1;
+	}
+	bool kinetic = strcmp(argv[2],"kinetic") == 0, fields = strcmp(argv[2],"flow") == 0;
+	double dx = atof(argv[3]), dy = atof(argv[4]), param = atof(argv[5]);
+	int bins = (argc >= 7) ? atoi(argv[6]) : 0;
+	long long s0 = (argc >= 9) ? atoll(argv[7]) : 0, s1 = (argc >= 9) ? atoll(argv[8]) : -1;
+	if(dx <= 0.0 || dy <= 0.0 || param <= 0.0){
+		fprintf(stderr,"dx, dy and %s must be positive\n", strcmp(argv[2],"structure") == 0 ? "atoms" : "mass");
+		return 1;
+	}
+	int2 dims = r.getDims();
+	int n = dims.x*dims.y;
+	int f0 = r.findFrame(s0);
+	int f1 = (s1 < 0) ? r.getFrames() : r.findFrame(s1 + 1);
+
+	Spectrum::Engine *spectrum = kinetic ? new Spectrum::Engine(dims.x, dims.y, dx, dy, bins) : NULL;
+	Spectrum::StructureFactor *structure = (kinetic || fields) ? NULL : new Spectrum::StructureFactor(dims.x, dims.y, dx, dy, bins, param);
+	Flow::Fields *flow = fields ? new Flow::Fields(dims.x, dims.y, dx, dy, bins) : NULL;
+	int nBins = kinetic ? spectrum->getBins() : fields ? 0 : structure->getBins();
+	double dk = kinetic ? spectrum->getShellWidth() : fields ? 0.0 : structure->getShellWidth();
+	int2 fd = fields ? flow->getDims() : make_int2(0, 0);
+	std::vector<double> e0(nBins), e1(nBins), density(fd.x*fd.y), vorticity(fd.x*fd.y);
+	std::vector<double2> current(fd.x*fd.y), velocity(fd.x*fd.y);
+	std::vector<double2> frame[2];
+	frame[0].resize(n);
+	frame[1].resize(n);
+	double2 *gpuWfc;
+	cudaMalloc((void**) &gpuWfc, sizeof(double2)*n);
+	char buffer[256];
+	const char *out = kinetic ? "ekc" : "sk";
+	int rc = (f0 < f1) ? r.readRegion(f0, 0, 0, dims.x, dims.y, frame[0].data()) : 0;
+	int step = 0;
+	for(int f = f0; f < f1 && rc == 0; ++f){
+		double2 *cur = frame[(f - f0) & 1].data(), *next = frame[(f - f0 + 1) & 1].data();
+		double t0, t1;
+		#pragma omp parallel sections num_threads(2)
+		{
+			#pragma omp section
+			{
+				if(f + 1 < f1)
+					rc = r.readRegion(f + 1, 0, 0, dims.x, dims.y, next);
+			}
+			#pragma omp section
+			{
+				cudaMemcpy(gpuWfc, cur, sizeof(double2)*n, cudaMemcpyHostToDevice);
+				if(kinetic)
+					spectrum->kinetic(gpuWfc, param, e0.data(), e1.data(), t0, t1);
+				else if(fields)
+					flow->compute(gpuWfc, param, density.data(), current.data(), velocity.data(), vorticity.data());
+				else
+					structure->accumulate(gpuWfc, e0.data(), t0);
+			}
+		}
+		step = (int) r.getStep(f);
+		if(fields){
+			int s = (bins < 1) ? 1 : bins;
+			FileIO::writeOutFlow(buffer, "flow", fd.x, fd.y, (1 - dims.x/2)*dx, (1 - dims.y/2)*dy, s*dx, s*dy,
+			                     density.data(), current.data(), velocity.data(), vorticity.data(), step);
+			continue;
+		}
+		FileIO::writeOutSpectrum(buffer, out, step, dk, nBins, t0, e0.data(), -1);
+		if(kinetic)
+			FileIO::writeOutSpectrum(buffer, "eki", step, dk, nBins, t1, e1.data(), -1);
+	}
+	if(structure != NULL && structure->getSamples() > 0){
+		int nk = dims.x*(dims.y/2 + 1);
+		std::vector<double> mean(nk), var(nk);
+		structure->getMoments(mean.data(), var.data(), e0.data(), e1.data());
+		FileIO::writeOutDouble(buffer, "sk_mean", mean.data(), nk, step);
+		FileIO::writeOutDouble(buffer, "sk_var", var.data(), nk, step);
+		FileIO::writeOutStructure(buffer, "sk_profile", dk, nBins, e0.data(), e1.data(), step);
+	}
+	delete spectrum;
+	delete structure;
+	delete flow;
+	cudaFree(gpuWfc);
+	if(rc != 0){
+		fprintf(stderr,"Cannot read %s\n",argv[1]);
+		return 1;
+	}
+	return 0;
+}
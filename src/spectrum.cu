@@ -0,0 +1,271 @@
+/*** spectrum.cu - GPUE: Split Operator based GPU solver for Nonlinear
+Schrodinger Equation, Copyright (C) 2011-2015, Lee J. O'Riordan
+<loriordan@gmail.com>, Tadhg Morgan, Neil Crowley.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <math.h>
+#include <string.h>
+#include "../include/spectrum.h"
+#include "../include/kernels.h"
+#include "../include/constants.h"
+
+namespace Spectrum {
+
+	static const int threads = 256;
+
+	/*
+	 * Counting sort of the stored modes by |k|, so each shell is a contiguous
+	 * run of the mode list. Row i holds yLen of the yDim columns; modes past
+	 * bins*dk go to an extra last shell, and k = 0 is left out if skipZero.
+	 */
+	static void sortShells(int xDim, int yDim, int yLen, double dkx, double dky, double dk, int bins, bool skipZero,
+	                       std::vector<int> &shellOf, std::vector<int> &start, std::vector<int> &modes){
+		shellOf.assign(xDim*yLen, -1);
+		start.assign(bins + 2, 0);
+		for(int i = 0; i < xDim; ++i){
+			double kx = dkx*((2*i <= xDim) ? i : i - xDim);
+			for(int j = 0; j < yLen; ++j){
+				double ky = dky*((2*j <= yDim) ? j : j - yDim);
+				if(skipZero && i == 0 && j == 0)
+					continue;
+				int b = (int)(sqrt(kx*kx + ky*ky)/dk);
+				shellOf[i*yLen + j] = (b < bins) ? b : bins;
+				++start[shellOf[i*yLen + j] + 1];
+			}
+		}
+		for(int b = 0; b <= bins; ++b)
+			start[b + 1] += start[b];
+		modes.resize(start[bins + 1]);
+		std::vector<int> next(start.begin(), start.end() - 1);
+		for(int m = 0; m < xDim*yLen; ++m)
+			if(shellOf[m] >= 0)
+				modes[next[shellOf[m]]++] = m;
+	}
+
+	/*
+	 * Shells of width max(dkx,dky), by default out to the Nyquist wavenumber
+	 * of the coarser axis.
+	 */
+	static int shellCount(int xDim, int yDim, double dkx, double dky, double dk, int bins){
+		double kMax = (xDim/2*dkx < yDim/2*dky) ? xDim/2*dkx : yDim/2*dky;
+		return (bins > 0) ? bins : (int)(kMax/dk);
+	}
+
+	Engine::Engine(int xDim, int yDim, double dx, double dy, int bins){
+		this->xDim = xDim;
+		this->yDim = yDim;
+		this->dx = dx;
+		this->dy = dy;
+		dkx = 2*PI/(xDim*dx);
+		dky = 2*PI/(yDim*dy);
+		dk = (dkx > dky) ? dkx : dky;
+		this->bins = shellCount(xDim, yDim, dkx, dky, dk, bins);
+		int n = xDim*yDim;
+		std::vector<int> shellOf, start, modes;
+		sortShells(xDim, yDim, yDim, dkx, dky, dk, this->bins, false, shellOf, start, modes);
+		shells.resize(2*(this->bins + 1));
+
+		cufftPlan2d(&plan, xDim, yDim, CUFFT_Z2Z);
+		cudaMalloc((void**) &gpuA, sizeof(double2)*n);
+		cudaMalloc((void**) &gpuB, sizeof(double2)*n);
+		cudaMalloc((void**) &gpuModes, sizeof(int)*n);
+		cudaMalloc((void**) &gpuShellStart, sizeof(int)*start.size());
+		cudaMalloc((void**) &gpuShells, sizeof(double)*shells.size());
+		cudaMemcpy(gpuModes, modes.data(), sizeof(int)*n, cudaMemcpyHostToDevice);
+		cudaMemcpy(gpuShellStart, start.data(), sizeof(int)*start.size(), cudaMemcpyHostToDevice);
+	}
+
+	Engine::~Engine(){
+		cufftDestroy(plan);
+		cudaFree(gpuA);
+		cudaFree(gpuB);
+		cudaFree(gpuModes);
+		cudaFree(gpuShellStart);
+		cudaFree(gpuShells);
+	}
+
+	int Engine::getBins(){
+		return bins;
+	}
+
+	double Engine::getShellWidth(){
+		return dk;
+	}
+
+	/*
+	 * Four transforms: psi forward, its two derivatives back, and ux + i uy
+	 * forward. With u_k the DFT, the energy is (m/2)(dx dy/(xDim yDim)) sum |u_k|^2.
+	 */
+	void Engine::kinetic(double2 *gpuWfc, double mass, double *ec, double *ei, double &ecTotal, double &eiTotal){
+		int n = xDim*yDim;
+		int blocks = (n + threads - 1)/threads;
+		cufftExecZ2Z(plan, gpuWfc, gpuA, CUFFT_FORWARD);
+		specGradient<<<blocks, threads>>>(gpuA, gpuB, gpuA, xDim, yDim, dkx, dky, 1.0/n);
+		cufftExecZ2Z(plan, gpuB, gpuB, CUFFT_INVERSE);
+		cufftExecZ2Z(plan, gpuA, gpuA, CUFFT_INVERSE);
+		packedVelocity<<<blocks, threads>>>(gpuWfc, gpuB, gpuA, HBAR/mass, n, gpuB);
+		cufftExecZ2Z(plan, gpuB, gpuB, CUFFT_FORWARD);
+		kineticShells<<<bins + 1, threads, 2*threads*sizeof(double)>>>(gpuB, gpuModes, gpuShellStart, xDim, yDim, dkx, dky, gpuShells);
+		cudaMemcpy(shells.data(), gpuShells, sizeof(double)*shells.size(), cudaMemcpyDeviceToHost);
+
+		double norm = 0.5*mass*dx*dy/n;
+		ecTotal = eiTotal = 0.0;
+		for(int b = 0; b <= bins; ++b){
+			ecTotal += norm*shells[b];
+			eiTotal += norm*shells[bins + 1 + b];
+			if(b < bins){
+				ec[b] = norm*shells[b]/dk;
+				ei[b] = norm*shells[bins + 1 + b]/dk;
+			}
+		}
+	}
+
+//######################################################################################################################
+
+	StructureFactor::StructureFactor(int xDim, int yDim, double dx, double dy, int bins, double num){
+		this->xDim = xDim;
+		this->yDim = yDim;
+		this->dx = dx;
+		this->dy = dy;
+		this->num = num;
+		yHalf = yDim/2 + 1;
+		samples = 0;
+		double dkx = 2*PI/(xDim*dx), dky = 2*PI/(yDim*dy);
+		dk = (dkx > dky) ? dkx : dky;
+		this->bins = shellCount(xDim, yDim, dkx, dky, dk, bins);
+		int n = xDim*yHalf;
+		std::vector<int> start, modes;
+		sortShells(xDim, yDim, yHalf, dkx, dky, dk, this->bins, true, shellOf, start, modes);
+		weight.assign(this->bins + 1, 0.0);
+		for(int m = 0; m < n; ++m)
+			if(shellOf[m] >= 0)
+				weight[shellOf[m]] += (m % yHalf == 0 || 2*(m % yHalf) == yDim) ? 1.0 : 2.0;
+		shells.resize(this->bins + 1);
+
+		cufftPlan2d(&plan, xDim, yDim, CUFFT_D2Z);
+		cudaMalloc((void**) &gpuDensity, sizeof(double)*xDim*yDim);
+		cudaMalloc((void**) &gpuNk, sizeof(double2)*n);
+		cudaMalloc((void**) &gpuMean, sizeof(double)*n);
+		cudaMalloc((void**) &gpuM2, sizeof(double)*n);
+		cudaMalloc((void**) &gpuModes, sizeof(int)*modes.size());
+		cudaMalloc((void**) &gpuShellStart, sizeof(int)*start.size());
+		cudaMalloc((void**) &gpuShells, sizeof(double)*shells.size());
+		cudaMemset(gpuMean, 0, sizeof(double)*n);
+		cudaMemset(gpuM2, 0, sizeof(double)*n);
+		cudaMemcpy(gpuModes, modes.data(), sizeof(int)*modes.size(), cudaMemcpyHostToDevice);
+		cudaMemcpy(gpuShellStart, start.data(), sizeof(int)*start.size(), cudaMemcpyHostToDevice);
+	}
+
+	StructureFactor::~StructureFactor(){
+		cufftDestroy(plan);
+		cudaFree(gpuDensity);
+		cudaFree(gpuNk);
+		cudaFree(gpuMean);
+		cudaFree(gpuM2);
+		cudaFree(gpuModes);
+		cudaFree(gpuShellStart);
+		cudaFree(gpuShells);
+	}
+
+	int StructureFactor::getBins(){
+		return bins;
+	}
+
+	double StructureFactor::getShellWidth(){
+		return dk;
+	}
+
+	int StructureFactor::getSamples(){
+		return samples;
+	}
+
+	/*
+	 * One real-to-complex transform per sample. The integral over k is
+	 * sum S(k)/(Lx Ly) by the mode density of the grid.
+	 */
+	void StructureFactor::accumulate(double2 *gpuWfc, double *profile, double &total){
+		int n = xDim*yHalf;
+		double scale = num*dx*dy;
+		densityField<<<(xDim*yDim + threads - 1)/threads, threads>>>(gpuWfc, xDim*yDim, gpuDensity);
+		cufftExecD2Z(plan, gpuDensity, gpuNk);
+		++samples;
+		structureAccumulate<<<(n + threads - 1)/threads, threads>>>(gpuNk, scale, samples, n, gpuMean, gpuM2);
+		structureShells<<<bins + 1, threads, threads*sizeof(double)>>>(gpuNk, gpuModes, gpuShellStart, yDim, scale, gpuShells);
+		cudaMemcpy(shells.data(), gpuShells, sizeof(double)*shells.size(), cudaMemcpyDeviceToHost);
+
+		total = 0.0;
+		for(int b = 0; b <= bins; ++b){
+			total += shells[b]/(xDim*dx*yDim*dy);
+			if(b < bins)
+				profile[b] = (weight[b] > 0.0) ? shells[b]/weight[b] : 0.0;
+		}
+	}
+
+	void StructureFactor::getMoments(double *mean, double *var, double *meanProfile, double *varProfile){
+		int n = xDim*yHalf;
+		std::vector<double> m(n), v(n);
+		cudaMemcpy(m.data(), gpuMean, sizeof(double)*n, cudaMemcpyDeviceToHost);
+		cudaMemcpy(v.data(), gpuM2, sizeof(double)*n, cudaMemcpyDeviceToHost);
+		for(int k = 0; k < n; ++k)
+			v[k] = (samples > 1) ? v[k]/(samples - 1) : 0.0;
+		if(mean != NULL)
+			memcpy(mean, m.data(), sizeof(double)*n);
+		if(var != NULL)
+			memcpy(var, v.data(), sizeof(double)*n);
+		std::vector<double> sm(bins + 1, 0.0), sv(bins + 1, 0.0);
+		for(int k = 0; k < n; ++k){
+			if(shellOf[k] < 0)
+				continue;
+			double w = (k % yHalf == 0 || 2*(k % yHalf) == yDim) ? 1.0 : 2.0;
+			sm[shellOf[k]] += w*m[k];
+			sv[shellOf[k]] += w*v[k];
+		}
+		for(int b = 0; b < bins; ++b){
+			if(meanProfile != NULL)
+				meanProfile[b] = (weight[b] > 0.0) ? sm[b]/weight[b] : 0.0;
+			if(varProfile != NULL)
+				varProfile[b] = (weight[b] > 0.0) ? sv[b]/weight[b] : 0.0;
+		}
+	}
+
+	void StructureFactor::getState(double *moments){
+		int n = xDim*yHalf;
+		cudaMemcpy(moments, gpuMean, sizeof(double)*n, cudaMemcpyDeviceToHost);
+		cudaMemcpy(moments + n, gpuM2, sizeof(double)*n, cudaMemcpyDeviceToHost);
+	}
+
+	void StructureFactor::setState(double *moments, int samples){
+		int n = xDim*yHalf;
+		cudaMemcpy(gpuMean, moments, sizeof(double)*n, cudaMemcpyHostToDevice);
+		cudaMemcpy(gpuM2, moments + n, sizeof(double)*n, cudaMemcpyHostToDevice);
+		this->samples = samples;
+	}
+}
@@ -44,7 +44,14 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../include/edge.h"
 #include "../include/manip.h"
 #include "../include/vort.h"
+#include "../include/runfile.h"
+#include "../include/trajfile.h"
+#include "../include/events.h"
+#include "../include/hexatic.h"
+#include "../include/spectrum.h"
+#include "../include/flow.h"
 #include <iostream>
+#include <algorithm>
 
 unsigned int LatticeGraph::Edge::suid = 0;
 unsigned int LatticeGraph::Node::suid = 0;
@@ -53,7 +60,11 @@ char buffer[100];
 int verbose; //Print more info. Not curently implemented.
 int device; //GPU ID choice.
 int kick_it; //Kicking mode: 0 = off, 1 = multiple, 2 = single
-int graph=0; //Generate graph from vortex lattice.
+int graph=0; //Generate graph from vortex lattice. 1 for Delaunay edges with defect counts every sample, 2 for the distance cutoff.
+int order_stats=0; //psi6 and Voronoi statistics at each sample. Needs graph=1.
+double g6_range=0.0; //Range of g6(r) in grid cells, written at print-outs. 0 = no g6.
+int g6_bins=100; //Number of g6(r) bins.
+int graph_out=0; //Graph file format. 0 text edge list, 1 text CSR, 2 binary edge list, 3 binary CSR, 4 dense Mathematica matrix.
 double gammaY; //Aspect ratio of trapping geometry.
 double omega; //Rotation rate of condensate
 double timeTotal;
@@ -65,6 +76,30 @@ double Rxy; //Condensate scaling factor.
 double a0x, a0y; //Harmonic oscillator length in x and y directions
 double sepMinEpsilon=0.0; //Minimum separation for epsilon.
 int kill_idx = -1;;
+int chk_steps = 0; //Steps between checkpoints. 0 = off.
+int resume = 0; //Continue from the last checkpoint.
+FileIO::Checkpoint chk; //Solver state restored on resume.
+struct Vtx::Vortex *chkVort = NULL; //Previous vortex coordinates restored on resume.
+double *chkSk = NULL; //Running S(k) moments restored on resume.
+int run_from = -1; //Step the current evolve() resumed from, -1 for a fresh run. Later frames in run containers are cut.
+Vtx::VtxList vortices; //Identities and lifetimes of every vortex tracked in real time.
+FileIO::OutPolicy outPol[16]; //Per-dataset output regions
+int numOutPol = 0;
+char outPolFile[256] = ""; //Output policy file. Empty for full output.
+int track_window = 4; //Half-width of incremental vortex tracking windows. 0 = full scan every time.
+int track_full = 16; //Tracking samples between forced full scans.
+double link_gate = 5.0; //Largest distance in grid cells a vortex may move between samples and keep its UID.
+int ls_stencil = 2; //Width of the least-squares stencil used to refine vortex cores, 2 or 4.
+int track_steps = 0; //Steps between vortex samples in real time. 0 = sample only at print-outs.
+int event_window = 0; //Samples held before and taken after a vortex event. 0 = no event output. Holds event_window wavefunctions on the device, 16*xDim*yDim bytes each.
+int event_steps = 1; //Steps between samples inside an event window.
+double event_jump = 2.0; //Displacement in grid cells between samples that counts as an event.
+int spec_steps = 0; //Steps between kinetic energy spectra in real time. 0 = off.
+int sf_steps = 0; //Steps between density structure factor samples in real time. 0 = off.
+int flow_stride = 0; //Decimation of the flow fields written with each snapshot. 0 = no flow fields.
+double mask_density = 0.01; //Vortex search mask threshold as a fraction of peak density. 0 = radius only.
+double *gpuX = NULL; //Device copy of x for the vortex search kernels.
+int2 *gpuSpan = NULL; //Vortex search mask, one plaquette range per row.
 /*
  * Checks CUDA routines have exitted correctly.
  */
@@ -352,7 +387,6 @@ int evolve( cufftDoubleComplex *gpuWfc,
 	//Double buffering and will attempt to thread free and calloc operations to hide time penalty. Or may not bother.
 	int num_vortices[2] = {0,0};
 	int num_latt_max = 0;
-	int* vortexLocation; //binary matrix of size xDim*yDim, 1 for vortex at specified index, 0 otherwise
 	int* olMaxLocation = (int*) calloc(xDim*yDim,sizeof(int));
 
 	struct Vtx::Vortex central_vortex; //vortex closest to the central position
@@ -372,14 +406,144 @@ int evolve( cufftDoubleComplex *gpuWfc,
 	
 	int num_kick = 0;
 	double t_kick = (2*PI/omega_0)/(6*Dt);
-	
-	for(int i=0; i < numSteps; ++i){
+	int vort_cap = 0; //Allocated length of vortCoords and vortCoordsP
+	int track_count = 0; //Tracking samples since the run started, for periodic full scans. Checkpointed, so a resumed run scans at the same samples
+	unsigned int next_uid = 0; //Next UID for a newly born vortex
+	int born = 0, died = 0; //Vortex births and deaths at the last sample
+	TrajFile::Writer traj; //Per-vortex trajectories, appended at each real-time sample
+	Events::Engine events; //Vortex events, and the windows of full output around them
+	double2 *gpuRing = NULL; //States of the last quiet samples, written out when an event fires
+	int ringSlot[64], ringStep[64];
+	std::vector<double2> psi6; //psi6 of each vortex at the last sample
+	std::vector<double> cellArea, g6(g6_bins), g6Pairs(g6_bins); //Voronoi cell areas, and binned g6(r)
+	std::vector<unsigned int> cellSides;
+	Spectrum::Engine *spectrum = NULL; //Kinetic energy spectra, allocated at the first sample
+	std::vector<double> ekc, eki;
+	Spectrum::StructureFactor *structure = NULL; //Running moments of S(k), allocated at the first sample
+	std::vector<double> sk;
+	int skStep = 0; //Step of the last S(k) sample
+	std::vector<double> skMoments; //Checkpoint copy of the S(k) moments
+
+	int start = 0;
+	if(resume && chk.gstate == (int)gstate){ //Pick up where the checkpoint left off. wfc is already on the device.
+		start = chk.step;
+		omega_0 = chk.omega_0;
+		num_kick = chk.num_kick;
+		num_vortices[0] = chk.num_vortices[0];
+		num_vortices[1] = chk.num_vortices[1];
+		vort_angle = chk.vort_angle;
+		sepAvg = chk.sepAvg;
+		central_vortex = chk.central_vortex;
+		next_uid = chk.nextUid;
+		track_count = chk.trackCount;
+		vort_cap = chk.vortCap;
+		if(vort_cap > 0){
+			vortCoordsP = chkVort;
+			vortCoords = (struct Vtx::Vortex *) malloc(sizeof(struct Vtx::Vortex) * vort_cap);
+		}
+		if(chk.skSamples > 0){ //Carry on the S(k) average rather than restarting it
+			structure = new Spectrum::StructureFactor(xDim, yDim, dx, dy, 0, N);
+			structure->setState(chkSk, chk.skSamples);
+			sk.resize(structure->getBins());
+			skStep = chk.skStep;
+		}
+		free(chkSk);
+		chkSk = NULL;
+		printf("Resuming at step %d\n", start);
+	}
+	run_from = (start > 0) ? start : -1;
+	if(gstate == 1)
+		traj.open("vort_traj", (start > 0) ? start : -1, 0);
+	if(gstate == 1 && event_window > 0 && events.open("vort_events", event_window, event_steps, event_jump, link_gate, run_from) == 0){
+		size_t ringBytes = sizeof(double2)*xDim*yDim*event_window;
+		if(cudaMalloc((void**) &gpuRing, ringBytes) != cudaSuccess){ //Without the ring the held states would be stale
+			fprintf(stderr, "Cannot allocate %.1f MiB for the event window; event output disabled\n", ringBytes/1048576.0);
+			gpuRing = NULL;
+			events.close();
+		}
+	}
+
+	for(int i=start; i < numSteps; ++i){
 		if ( ramp == 1 ){
 			omega_0=omegaX*((omega-0.39)*((double)i/(double)(numSteps)) + 0.39); //Adjusts omega for the appropriate trap frequency.
 		}
+		if(chk_steps > 0 && i % chk_steps == 0 && i != start){ //Checkpoint the state at the start of this step.
+			cudaMemcpy(wfc, gpuWfc, sizeof(cufftDoubleComplex) * xDim * yDim, cudaMemcpyDeviceToHost);
+			chk.gstate = gstate;
+			chk.step = i;
+			chk.omega_0 = omega_0;
+			chk.num_kick = num_kick;
+			chk.num_vortices[0] = num_vortices[0];
+			chk.num_vortices[1] = num_vortices[1];
+			chk.vortCap = vort_cap;
+			chk.hasOpt = (gstate == 1 && vort_cap > 0);
+			chk.vort_angle = vort_angle;
+			chk.sepAvg = sepAvg;
+			chk.central_vortex = central_vortex;
+			chk.nextUid = next_uid;
+			chk.trackCount = track_count;
+			chk.skSamples = (structure != NULL) ? structure->getSamples() : 0;
+			chk.skStep = skStep;
+			if(chk.skSamples > 0){
+				skMoments.resize(2*xDim*(yDim/2 + 1));
+				structure->getState(skMoments.data());
+			}
+			FileIO::writeCheckpoint("checkpoint.chk", chk, wfc, xDim, yDim, vortCoordsP, EV_opt, params, vortices, skMoments.data());
+		}
+		if(gstate == 1 && ramp == 0 && (i % printSteps == 0 || (track_steps > 0 && i % track_steps == 0) || events.sampleDue(i))){ //Vortex sampling. Detection, linking and the lattice graph; snapshots and graph output wait for the print-out.
+			num_vortices[0] = -1;
+			if (track_window > 0 && num_vortices[1] > 0 && (track_full <= 0 || ++track_count % track_full != 0))
+				num_vortices[0] = trackVortexDevice(gpuWfc, vortCoordsP, num_vortices[1], vortCoords, vort_cap);
+			if (num_vortices[0] < 0)
+				num_vortices[0] = findVortexDevice(gpuWfc, 2e-4, vortCoords, vort_cap);
+			if (num_vortices[0] > vort_cap) { //Grow both lists and fetch again.
+				vortCoords = (struct Vtx::Vortex *) realloc(vortCoords, sizeof(struct Vtx::Vortex) * 2 * num_vortices[0]);
+				vortCoordsP = (struct Vtx::Vortex *) realloc(vortCoordsP, sizeof(struct Vtx::Vortex) * 2 * num_vortices[0]);
+				memset(vortCoordsP + vort_cap, 0, sizeof(struct Vtx::Vortex) * (2 * num_vortices[0] - vort_cap));
+				vort_cap = 2 * num_vortices[0];
+				findVortexDevice(gpuWfc, 2e-4, vortCoords, vort_cap);
+			}
+
+			Tracker::linkVortices(vortCoordsP, num_vortices[1], vortCoords, num_vortices[0], link_gate, &next_uid);
+			vortices.update(vortCoords, num_vortices[0], i);
+			vortices.lastChanges(born, died);
+			traj.append(vortCoords, num_vortices[0], i);
+			if (i != 0 && (born > 0 || died > 0))
+				printf("Step %d vortices: %d born, %d died, %d tracked in total\n", i, born, died, vortices.size());
+			if (events.isOpen()) { //Write the held states on a trigger, then every sample until the window closes
+				if (events.observe(vortCoordsP, num_vortices[1], vortCoords, num_vortices[0], i) != 0) {
+					int held = events.drain(ringSlot, ringStep);
+					for (int k = 0; k < held; ++k)
+						writeSnapshot("wfc_event", gpuRing + (size_t) ringSlot[k]*xDim*yDim, wfc, ringStep[k]);
+				}
+				if (events.inWindow(i))
+					writeSnapshot("wfc_event", gpuWfc, wfc, i);
+				else
+					cudaMemcpy(gpuRing + (size_t) events.push(i)*xDim*yDim, gpuWfc, sizeof(double2)*xDim*yDim, cudaMemcpyDeviceToDevice);
+			}
+			if (graph == 2) { //The print-out writes this sample's graph
+				lattice.setVortices(vortCoords, num_vortices[0]);
+				lattice.createEdges(1.5 * 2e-5 / dx);
+			}
+			else if (graph == 1) { //Updated from the last sample by vortex UID
+				lattice.updateVortices(vortCoords, num_vortices[0]);
+				unsigned int zCount[10];
+				unsigned int defects = lattice.countDefects(zCount);
+				FileIO::writeOutDefects(buffer, "vort_defects", i, num_vortices[0], defects, zCount, run_from);
+				if (order_stats) {
+					psi6.resize(num_vortices[0]);
+					cellArea.resize(num_vortices[0]);
+					cellSides.resize(num_vortices[0]);
+					Hexatic::psi6(lattice, psi6.data());
+					lattice.getVoronoi(cellArea.data(), cellSides.data());
+					Hexatic::writeSummary("vort_order", i, Hexatic::summarise(lattice, psi6.data(), cellArea.data(), cellSides.data()), run_from);
+				}
+			}
+			num_vortices[1] = num_vortices[0];
+			memcpy(vortCoordsP, vortCoords, sizeof(struct Vtx::Vortex) * num_vortices[0]);
+		}
 		if(i % printSteps == 0) { //Print-out at pre-determined rate. Vortex & wfc analysis performed here also.
 			printf("Step: %d	Omega: %lf\n", i, omega_0 / omegaX);
-			cudaMemcpy(wfc, gpuWfc, sizeof(cufftDoubleComplex) * xDim * yDim, cudaMemcpyDeviceToHost);
 			end = clock();
 			time_spent = (double) (end - begin) / CLOCKS_PER_SEC;
 			printf("Time spent: %lf\n", time_spent);
@@ -394,16 +558,7 @@ int evolve( cufftDoubleComplex *gpuWfc,
 			        break;
 				case 2: //Real-time evolution, constant Omega value.
 					fileName = "wfc_ev";
-			        vortexLocation = (int *) calloc(xDim * yDim, sizeof(int));
-			        num_vortices[0] = Tracker::findVortex(vortexLocation, wfc, 2e-4, xDim, x, i);
-
 			        if (i == 0) { //If initial step, locate vortices, least-squares to find exact centre, calculate lattice angle, generate optical lattice.
-				        vortCoords = (struct Vtx::Vortex *) malloc(
-						        sizeof(struct Vtx::Vortex) * (2 * num_vortices[0]));
-				        vortCoordsP = (struct Vtx::Vortex *) malloc(
-						        sizeof(struct Vtx::Vortex) * (2 * num_vortices[0]));
-				        Tracker::vortPos(vortexLocation, vortCoords, xDim, wfc);
-				        Tracker::lsFit(vortCoords, wfc, num_vortices[0], xDim);
 				        central_vortex = Tracker::vortCentre(vortCoords, num_vortices[0], xDim);
 				        vort_angle = Tracker::vortAngle(vortCoords, central_vortex, num_vortices[0]);
 				        appendData(&params, "Vort_angle", vort_angle);
@@ -423,33 +578,20 @@ int evolve( cufftDoubleComplex *gpuWfc,
 				        appendData(&params, "Num_vort", (double) num_vortices[0]);
 				        FileIO::writeOutParam(buffer, params, "Params.dat");
 			        }
-			        else if (num_vortices[0] > num_vortices[1]) {
-				        printf("Number of vortices increased from %d to %d\n", num_vortices[1], num_vortices[0]);
-				        Tracker::vortPos(vortexLocation, vortCoords, xDim, wfc);
-				        Tracker::lsFit(vortCoords, wfc, num_vortices[0], xDim);
-			        }
-			        else {
-				        Tracker::vortPos(vortexLocation, vortCoords, xDim, wfc);
-				        Tracker::lsFit(vortCoords, wfc, num_vortices[0], xDim);
-				        Tracker::vortArrange(vortCoords, vortCoordsP, num_vortices[0]);
-			        }
 
-			        if (graph == 1) {
+			        if (graph > 0) {
 
-				        for (unsigned int ii = 0; ii < num_vortices[0]; ++ii) {
-					        std::shared_ptr<LatticeGraph::Node> n(new LatticeGraph::Node(vortCoords[ii]));
-					        lattice.addVortex(std::move(n));
-				        }
 				        unsigned int *uids = (unsigned int *) malloc(
-						        sizeof(unsigned int) * lattice.getVortices().size());
-				        for (int a = 0; a < lattice.getVortices().size(); ++a) {
-					        uids[a] = lattice.getVortexIdx(a)->getUid();
+						        sizeof(unsigned int) * lattice.getNumVortices());
+				        for (int a = 0; a < lattice.getNumVortices(); ++a) {
+					        uids[a] = lattice.getUidIdx(a);
 				        }
 				        if(i==0) {
 					        //Lambda for vortex annihilation/creation.
 					        auto killIt=[&](int idx, int winding, double delta_x) {
-					            WFC::phaseWinding(Phi, winding, x, y, dx, dy, lattice.getVortexUid(idx)->getData().coordsD.x + cos(angle_sweep + vort_angle)*delta_x,
-					                          lattice.getVortexUid(idx)->getData().coordsD.y + sin(angle_sweep + vort_angle)*delta_x, xDim);
+					            const Vtx::Vortex &v = lattice.getVortexData(lattice.getVortexIdxUid(idx));
+					            WFC::phaseWinding(Phi, winding, x, y, dx, dy, v.coordsD.x + cos(angle_sweep + vort_angle)*delta_x,
+					                          v.coordsD.y + sin(angle_sweep + vort_angle)*delta_x, xDim);
 					            cudaMemcpy(Phi_gpu, Phi, sizeof(double) * xDim * yDim, cudaMemcpyHostToDevice);
 					            cMultPhi <<<grid, threads>>> (gpuWfc, Phi_gpu, gpuWfc);
 				        	};
@@ -458,24 +600,44 @@ int evolve( cufftDoubleComplex *gpuWfc,
 						}
 
 				        }
-				        lattice.createEdges(1.5 * 2e-5 / dx);
-				        adjMat = (double *) calloc(lattice.getVortices().size() * lattice.getVortices().size(),
-				                                   sizeof(double));
-				        lattice.genAdjMat(adjMat);
-				        FileIO::writeOutAdjMat(buffer, "graph", adjMat, uids, lattice.getVortices().size(), i);
-				        free(adjMat);
+				        if (graph_out == 4) {
+					        adjMat = (double *) calloc(lattice.getNumVortices() * lattice.getNumVortices(),
+					                                   sizeof(double));
+					        lattice.genAdjMat(adjMat);
+					        FileIO::writeOutAdjMat(buffer, "graph", adjMat, uids, lattice.getNumVortices(), i);
+					        free(adjMat);
+				        }
+				        else if (graph_out == 1 || graph_out == 3)
+					        FileIO::writeOutCSR(buffer, "graph_csr", uids, lattice.getRowPtr().data(), lattice.getColIdx().data(),
+					                            lattice.getColWeight().data(), lattice.getNumVortices(), graph_out == 3, i);
+				        else
+					        FileIO::writeOutEdgeList(buffer, "graph_el", uids, lattice.getRowPtr().data(), lattice.getColIdx().data(),
+					                                 lattice.getColWeight().data(), lattice.getNumVortices(), graph_out == 2, i);
+				        if (graph == 1) {
+					        unsigned int *coord = (unsigned int *) malloc(sizeof(unsigned int) * lattice.getNumVortices());
+					        char *hull = (char *) malloc(sizeof(char) * lattice.getNumVortices());
+					        for (int a = 0; a < lattice.getNumVortices(); ++a) {
+						        coord[a] = lattice.getCoordination(a);
+						        hull[a] = lattice.isOnHull(a);
+					        }
+					        FileIO::writeOutCoordination(buffer, "vort_coord", vortCoords, coord, hull, lattice.getNumVortices(), i);
+					        free(coord);
+					        free(hull);
+					        if (order_stats) {
+						        FileIO::writeOutOrder(buffer, "vort_psi6", vortCoords, psi6.data(), cellArea.data(), cellSides.data(), num_vortices[0], i);
+						        if (g6_range > 0.0) {
+							        Hexatic::g6(vortCoords, psi6.data(), num_vortices[0], g6_range, g6_bins, g6.data(), g6Pairs.data());
+							        FileIO::writeOutG6(buffer, "vort_g6", g6_range, g6_bins, g6.data(), g6Pairs.data(), i);
+						        }
+					        }
+				        }
 				        free(uids);
-				        lattice.getVortices().clear();
-				        lattice.getEdges().clear();
 				        //exit(0);
 			        }
 
-			        FileIO::writeOutVortex(buffer, "vort_arr", vortCoords, num_vortices[0], i);
+			        FileIO::writeOutVortexUid(buffer, "vort_arr", vortCoords, num_vortices[0], i);
 			        printf("Located %d vortices\n", num_vortices[0]);
 			        printf("Sigma=%e\n", vortOLSigma);
-			        free(vortexLocation);
-			        num_vortices[1] = num_vortices[0];
-			        memcpy(vortCoordsP, vortCoords, sizeof(int2) * num_vortices[0]);
 			        //exit(1);
 			        break;
 				case 3:
@@ -485,7 +647,10 @@ int evolve( cufftDoubleComplex *gpuWfc,
 					break;
 			}
 			if (write_it) {
-				FileIO::writeOut(buffer, fileName, wfc, xDim * yDim, i);
+				writeSnapshot(fileName, gpuWfc, wfc, i);
+			}
+			if (flow_stride > 0) {
+				writeFlow(fileName, gpuWfc, i);
 			}
 			//printf("Energy[t@%d]=%E\n",i,energy_angmom(gpuPositionOp, gpuMomentumOp, dx, dy, gpuWfc,gstate));
 /*			cudaMemcpy(V_gpu, V, sizeof(double)*xDim*yDim, cudaMemcpyHostToDevice);
@@ -494,6 +659,27 @@ int evolve( cufftDoubleComplex *gpuWfc,
 			cudaMemcpy(K_gpu, K, sizeof(double)*xDim*yDim, cudaMemcpyHostToDevice);
 */		}
 	
+		if(gstate == 1 && spec_steps > 0 && i % spec_steps == 0){ //Compressible and incompressible kinetic energy spectra
+			double ecTotal, eiTotal;
+			if(spectrum == NULL){
+				spectrum = new Spectrum::Engine(xDim, yDim, dx, dy, 0);
+				ekc.resize(spectrum->getBins());
+				eki.resize(spectrum->getBins());
+			}
+			spectrum->kinetic(gpuWfc, mass, ekc.data(), eki.data(), ecTotal, eiTotal);
+			FileIO::writeOutSpectrum(buffer, "ekc", i, spectrum->getShellWidth(), spectrum->getBins(), ecTotal, ekc.data(), run_from);
+			FileIO::writeOutSpectrum(buffer, "eki", i, spectrum->getShellWidth(), spectrum->getBins(), eiTotal, eki.data(), run_from);
+		}
+		if(gstate == 1 && sf_steps > 0 && i % sf_steps == 0){ //Density structure factor, accumulated over the run
+			double total;
+			if(structure == NULL){
+				structure = new Spectrum::StructureFactor(xDim, yDim, dx, dy, 0, N);
+				sk.resize(structure->getBins());
+			}
+			structure->accumulate(gpuWfc, sk.data(), total);
+			FileIO::writeOutSpectrum(buffer, "sk", i, structure->getShellWidth(), structure->getBins(), total, sk.data(), run_from);
+			skStep = i;
+		}
 	/** ** ####################################################################################################### ** **/
 	/** ** ####################################################################################################### ** **/
 	/** ** 							More F'n' Dragons!				       ** **/
@@ -620,6 +806,24 @@ int evolve( cufftDoubleComplex *gpuWfc,
 			parSum(gpuWfc, gpuParSum, xDim, yDim, threads);
 		}
 	}
+	if(vortices.size() > 0)
+		FileIO::writeOutVortexLife(buffer, "vort_life", vortices);
+	if(traj.isOpen())
+		traj.close();
+	if(events.isOpen()){
+		events.close();
+		cudaFree(gpuRing);
+	}
+	delete spectrum;
+	if(structure != NULL){
+		int n = xDim*(yDim/2 + 1);
+		std::vector<double> mean(n), var(n), skVar(structure->getBins());
+		structure->getMoments(mean.data(), var.data(), sk.data(), skVar.data());
+		FileIO::writeOutDouble(buffer, "sk_mean", mean.data(), n, skStep);
+		FileIO::writeOutDouble(buffer, "sk_var", var.data(), n, skStep);
+		FileIO::writeOutStructure(buffer, "sk_profile", structure->getShellWidth(), structure->getBins(), sk.data(), skVar.data(), skStep);
+		delete structure;
+	}
 	return 0;
 }
 
@@ -647,6 +851,204 @@ void parSum(double2* gpuWfc, double2* gpuParSum, int xDim, int yDim, int threads
 		scalarDiv_wfcNorm<<<grid,threads>>>(gpuWfc, dx*dy, gpuParSum, gpuWfc);
 }
 
+/*
+ * Writes the wavefunction for the given step, reduced by the dataset's output policy if it has one.
+ */
+void writeSnapshot(char *fileName, double2 *gpuWfc, double2 *hostWfc, int step){
+	FileIO::OutPolicy *p = FileIO::findOutPolicy(fileName, outPol, numOutPol);
+	double2 *data = hostWfc;
+	int nx = xDim, ny = yDim;
+	if(p == NULL || p->mode != FileIO::OUT_SPECTRAL)
+		cudaMemcpy(hostWfc, gpuWfc, sizeof(double2)*xDim*yDim, cudaMemcpyDeviceToHost);
+	if(p != NULL){
+		nx = p->nx;
+		ny = p->ny;
+		data = (double2*) malloc(sizeof(double2)*nx*ny);
+		if(p->mode == FileIO::OUT_SPECTRAL)
+			spectralDownsample(gpuWfc, nx, ny, data);
+		else
+			FileIO::applyOutPolicy(*p, hostWfc, xDim, yDim, data);
+		FileIO::writeOutMeta(buffer, fileName, *p, x, y, xDim, yDim);
+	}
+	if(write_it == 3){ //All snapshots of the dataset in one tiled container
+		sprintf(buffer, "%s.run", fileName);
+		RunFile::appendFrame(buffer, data, nx, ny, 64, step, run_from);
+	}
+	else if(write_it == 2)
+		FileIO::writeOutBin(buffer, fileName, data, nx, ny, step);
+	else
+		FileIO::writeOut(buffer, fileName, data, nx*ny, step);
+	if(data != hostWfc)
+		free(data);
+}
+
+/*
+ * The field buffers are kept between calls.
+ */
+void writeFlow(char *fileName, double2 *gpuWfc, int step){
+	static Flow::Fields *flow = NULL;
+	static std::vector<double> density, vorticity;
+	static std::vector<double2> current, velocity;
+	char name[256];
+	if(flow == NULL){
+		flow = new Flow::Fields(xDim, yDim, dx, dy, flow_stride);
+		int2 d = flow->getDims();
+		density.resize(d.x*d.y);
+		vorticity.resize(d.x*d.y);
+		current.resize(d.x*d.y);
+		velocity.resize(d.x*d.y);
+	}
+	int2 d = flow->getDims();
+	flow->compute(gpuWfc, mass, density.data(), current.data(), velocity.data(), vorticity.data());
+	sprintf(name, "%s_flow", fileName);
+	FileIO::writeOutFlow(buffer, name, d.x, d.y, x[0], y[0], flow_stride*dx, flow_stride*dy,
+	                     density.data(), current.data(), velocity.data(), vorticity.data(), step);
+}
+
+/*
+ * Fourier-truncates the device wavefunction to nx*ny modes and returns the
+ * field resampled on the coarser grid. Buffers and the small plan are kept
+ * between calls.
+ */
+void spectralDownsample(double2 *gpuWfc, int nx, int ny, double2 *out){
+	static double2 *gpuScratch = NULL, *gpuSmall = NULL;
+	static cufftHandle plan_small;
+	static int nxP = 0, nyP = 0;
+	if(gpuScratch == NULL)
+		cudaMalloc((void**) &gpuScratch, sizeof(double2)*xDim*yDim);
+	if(nx != nxP || ny != nyP){
+		if(gpuSmall != NULL){
+			cufftDestroy(plan_small);
+			cudaFree(gpuSmall);
+		}
+		cudaMalloc((void**) &gpuSmall, sizeof(double2)*nx*ny);
+		cufftPlan2d(&plan_small, nx, ny, CUFFT_Z2Z);
+		nxP = nx; nyP = ny;
+	}
+	cudaMemcpy(gpuScratch, gpuWfc, sizeof(double2)*xDim*yDim, cudaMemcpyDeviceToDevice);
+	cufftExecZ2Z(plan_2d, gpuScratch, gpuScratch, CUFFT_FORWARD);
+	fftCrop<<<(nx*ny + threads - 1)/threads, threads>>>(gpuScratch, gpuSmall, xDim, yDim, nx, ny, 1.0/(xDim*yDim));
+	cufftExecZ2Z(plan_small, gpuSmall, gpuSmall, CUFFT_INVERSE);
+	cudaMemcpy(out, gpuSmall, sizeof(double2)*nx*ny, cudaMemcpyDeviceToHost);
+}
+
+/*
+ * Rebuilds the vortex search mask: per row, the plaquettes inside radius lying
+ * between the first and last with all corners above mask_density of the peak. Only xDim row maxima come
+ * back to the host.
+ */
+void densityMask(double2 *gpuWfc, double radius){
+	static double *gpuRowMax = NULL, *rowMax = NULL;
+	double thresh = 0.0;
+	if(gpuX == NULL){
+		cudaMalloc((void**) &gpuX, sizeof(double)*xDim);
+		cudaMemcpy(gpuX, x, sizeof(double)*xDim, cudaMemcpyHostToDevice);
+		cudaMalloc((void**) &gpuSpan, sizeof(int2)*xDim);
+		cudaMalloc((void**) &gpuRowMax, sizeof(double)*xDim);
+		rowMax = (double*) malloc(sizeof(double)*xDim);
+	}
+	if(mask_density > 0.0){
+		rowDensityMax<<<(xDim + threads - 1)/threads, threads>>>(gpuWfc, xDim, gpuRowMax);
+		cudaMemcpy(rowMax, gpuRowMax, sizeof(double)*xDim, cudaMemcpyDeviceToHost);
+		for(int i = 0; i < xDim; ++i)
+			thresh = (rowMax[i] > thresh) ? rowMax[i] : thresh;
+		thresh *= mask_density;
+	}
+	densitySpan<<<(xDim + threads - 1)/threads, threads>>>(gpuWfc, gpuX, radius*radius, thresh, xDim, gpuSpan);
+}
+
+/*
+ * Refines num vortices in gpuVort, copies them back sorted into grid order
+ * and writes at most cap of them to vortCoords.
+ */
+void fetchVortices(double2 *gpuWfc, struct Vtx::Vortex *gpuVort, int num, struct Vtx::Vortex *vortCoords, int cap){
+	static struct Vtx::Vortex *hostVort = NULL;
+	static int hostCap = 0;
+	if(num > hostCap){
+		free(hostVort);
+		hostCap = 2*num;
+		hostVort = (struct Vtx::Vortex*) malloc(sizeof(struct Vtx::Vortex)*hostCap);
+	}
+	lsFitGPU<<<(num + threads - 1)/threads, threads>>>(gpuWfc, gpuVort, num, xDim, ls_stencil);
+	cudaMemcpy(hostVort, gpuVort, sizeof(struct Vtx::Vortex)*num, cudaMemcpyDeviceToHost);
+	std::sort(hostVort, hostVort + num, [](const struct Vtx::Vortex &a, const struct Vtx::Vortex &b){
+		return a.coords.x < b.coords.x || (a.coords.x == b.coords.x && a.coords.y < b.coords.y);
+	});
+	memcpy(vortCoords, hostVort, sizeof(struct Vtx::Vortex)*(num < cap ? num : cap));
+}
+
+/*
+ * Finds vortices and refines their cores on the device. Only the compact list
+ * is copied back, sorted into grid order. Returns the number found, of which
+ * at most cap are written to vortCoords.
+ */
+int findVortexDevice(double2 *gpuWfc, double radius, struct Vtx::Vortex *vortCoords, int cap){
+	static int *gpuCount = NULL;
+	static struct Vtx::Vortex *gpuVort = NULL;
+	static int gpuCap = 0;
+	int num = 0;
+	if(gpuCount == NULL)
+		cudaMalloc((void**) &gpuCount, sizeof(int));
+	densityMask(gpuWfc, radius);
+	do{
+		if(num > gpuCap){
+			cudaFree(gpuVort);
+			gpuCap = 2*num;
+			cudaMalloc((void**) &gpuVort, sizeof(struct Vtx::Vortex)*gpuCap);
+		}
+		cudaMemset(gpuCount, 0, sizeof(int));
+		findVortexGPU<<<grid,threads>>>(gpuWfc, gpuSpan, xDim, gpuVort, gpuCount, gpuCap);
+		cudaMemcpy(&num, gpuCount, sizeof(int), cudaMemcpyDeviceToHost);
+	} while(num > gpuCap);
+	if(num > 0)
+		fetchVortices(gpuWfc, gpuVort, num, vortCoords, cap);
+	return num;
+}
+
+/*
+ * Searches only the (2*track_window+1)^2 plaquettes around each previous
+ * vortex, within the mask from the last full scan. Returns the number
+ * found, or -1 if the result cannot be trusted because the count changed or
+ * the net winding disagrees with the phase circulation around the mask edge.
+ */
+int trackVortexDevice(double2 *gpuWfc, struct Vtx::Vortex *prev, int numPrev, struct Vtx::Vortex *vortCoords, int cap){
+	static int *gpuCount = NULL;
+	static unsigned int *gpuStamp = NULL;
+	static unsigned int epoch = 0;
+	static struct Vtx::Vortex *gpuPrev = NULL, *gpuVort = NULL;
+	static int gpuCap = 0;
+	int side = 2*track_window + 1;
+	int counts[2], net = 0;
+	if(gpuSpan == NULL)
+		return -1;
+	if(gpuStamp == NULL){
+		cudaMalloc((void**) &gpuStamp, sizeof(unsigned int)*xDim*xDim);
+		cudaMemset(gpuStamp, 0, sizeof(unsigned int)*xDim*xDim);
+		cudaMalloc((void**) &gpuCount, 2*sizeof(int));
+	}
+	if(numPrev > gpuCap){
+		cudaFree(gpuPrev);
+		cudaFree(gpuVort);
+		gpuCap = 2*numPrev;
+		cudaMalloc((void**) &gpuPrev, sizeof(struct Vtx::Vortex)*gpuCap);
+		cudaMalloc((void**) &gpuVort, sizeof(struct Vtx::Vortex)*gpuCap);
+	}
+	cudaMemcpy(gpuPrev, prev, sizeof(struct Vtx::Vortex)*numPrev, cudaMemcpyHostToDevice);
+	cudaMemset(gpuCount, 0, 2*sizeof(int));
+	++epoch;
+	trackVortexWindow<<<(numPrev*side*side + threads - 1)/threads, threads>>>(gpuWfc, gpuSpan, xDim, gpuPrev, numPrev, track_window, gpuStamp, epoch, gpuVort, gpuCount, gpuCap);
+	boundaryWinding<<<(xDim + threads - 1)/threads, threads>>>(gpuWfc, gpuSpan, xDim, gpuCount + 1);
+	cudaMemcpy(counts, gpuCount, 2*sizeof(int), cudaMemcpyDeviceToHost);
+	if(counts[0] != numPrev || counts[0] > cap)
+		return -1;
+	fetchVortices(gpuWfc, gpuVort, counts[0], vortCoords, cap);
+	for(int k = 0; k < counts[0]; ++k)
+		net += vortCoords[k].wind;
+	if(net != counts[1])
+		return -1;
+	return counts[0];
+}
+
 /**
 ** Matches the optical lattice to the vortex lattice. Moire super-lattice project.
 **/
@@ -769,7 +1171,28 @@ template<typename T> void parSum(T *gpuToSumArr, T *gpuParSum, int xDim, int yDi
 //###################################################################################################################
 int parseArgs(int argc, char** argv){
 	int opt;
-	while ((opt = getopt (argc, argv, "D:d:x:y:w:G:g:e:T:t:n:p:r:o:L:l:s:i:P:X:Y:O:k:W:U:V:S:a:K:")) != -1) {
+	static struct option long_opts[] = {
+		{"resume", no_argument, NULL, 'R'},
+		{"out-policy", required_argument, NULL, 'Q'},
+		{"track-window", required_argument, NULL, 'J'},
+		{"track-full", required_argument, NULL, 'F'},
+		{"mask-density", required_argument, NULL, 'M'},
+		{"link-gate", required_argument, NULL, 'N'},
+		{"ls-stencil", required_argument, NULL, 'B'},
+		{"track-steps", required_argument, NULL, 'c'},
+		{"graph-out", required_argument, NULL, 'H'},
+		{"order", required_argument, NULL, 'z'},
+		{"g6-range", required_argument, NULL, 'Z'},
+		{"g6-bins", required_argument, NULL, 'b'},
+		{"spectrum", required_argument, NULL, 'E'},
+		{"structure", required_argument, NULL, 'A'},
+		{"flow", required_argument, NULL, 'u'},
+		{"event-window", required_argument, NULL, 'f'}, //Costs event_window full wavefunctions of device memory
+		{"event-steps", required_argument, NULL, 'q'},
+		{"event-jump", required_argument, NULL, 'j'},
+		{NULL, 0, NULL, 0}
+	};
+	while ((opt = getopt_long (argc, argv, "D:d:x:y:w:G:g:e:T:t:n:p:r:o:L:l:s:i:P:X:Y:O:k:W:U:V:S:a:K:C:RQ:J:F:M:N:B:c:f:q:j:H:z:Z:b:E:A:u:", long_opts, NULL)) != -1) {
 		switch (opt)
 		{
 			case 'x':
@@ -912,6 +1335,115 @@ int parseArgs(int argc, char** argv){
 				printf("Argument for kill_idx is %d\n",kill_idx);
 				appendData(&params,"kill_idx",kill_idx);
 				break;
+			case 'C':
+				chk_steps = atoi(optarg);
+				printf("Argument for checkpoint steps is %d\n",chk_steps);
+				appendData(&params,"chk_steps",chk_steps);
+				break;
+			case 'R':
+				resume = 1;
+				printf("Resuming from checkpoint.chk\n");
+				break;
+			case 'Q':
+				strncpy(outPolFile, optarg, sizeof(outPolFile) - 1);
+				printf("Output policies read from %s\n",outPolFile);
+				break;
+			case 'J':
+				track_window = atoi(optarg);
+				printf("Argument for tracking window is %d\n",track_window);
+				appendData(&params,"track_window",track_window);
+				break;
+			case 'F':
+				track_full = atoi(optarg);
+				printf("Argument for full vortex scan interval is %d\n",track_full);
+				appendData(&params,"track_full",track_full);
+				break;
+			case 'M':
+				mask_density = atof(optarg);
+				printf("Argument for vortex mask density fraction is %E\n",mask_density);
+				appendData(&params,"mask_density",mask_density);
+				break;
+			case 'N':
+				link_gate = atof(optarg);
+				if(!(link_gate > 0.0)){
+					printf("Vortex link gate must be positive\n");
+					exit(-1);
+				}
+				printf("Argument for vortex link gate is %E\n",link_gate);
+				appendData(&params,"link_gate",link_gate);
+				break;
+			case 'B':
+				ls_stencil = atoi(optarg);
+				if(ls_stencil != 2 && ls_stencil != 4){
+					printf("Least-squares stencil must be 2 or 4\n");
+					exit(-1);
+				}
+				printf("Argument for least-squares stencil is %d\n",ls_stencil);
+				appendData(&params,"ls_stencil",ls_stencil);
+				break;
+			case 'c':
+				track_steps = atoi(optarg);
+				printf("Argument for vortex tracking steps is %d\n",track_steps);
+				appendData(&params,"track_steps",track_steps);
+				break;
+			case 'H':
+				graph_out = atoi(optarg);
+				printf("Argument for graph output format is %d\n",graph_out);
+				appendData(&params,"graph_out",graph_out);
+				break;
+			case 'z':
+				order_stats = atoi(optarg);
+				printf("Argument for order statistics is %d\n",order_stats);
+				appendData(&params,"order_stats",order_stats);
+				break;
+			case 'Z':
+				g6_range = atof(optarg);
+				printf("Argument for g6 range is %E\n",g6_range);
+				appendData(&params,"g6_range",g6_range);
+				break;
+			case 'b':
+				g6_bins = atoi(optarg);
+				if(g6_bins < 1){
+					printf("g6 bins must be at least 1\n");
+					exit(-1);
+				}
+				printf("Argument for g6 bins is %d\n",g6_bins);
+				appendData(&params,"g6_bins",g6_bins);
+				break;
+			case 'E':
+				spec_steps = atoi(optarg);
+				printf("Argument for kinetic energy spectrum steps is %d\n",spec_steps);
+				appendData(&params,"spec_steps",spec_steps);
+				break;
+			case 'A':
+				sf_steps = atoi(optarg);
+				printf("Argument for structure factor steps is %d\n",sf_steps);
+				appendData(&params,"sf_steps",sf_steps);
+				break;
+			case 'u':
+				flow_stride = atoi(optarg);
+				printf("Argument for flow field stride is %d\n",flow_stride);
+				appendData(&params,"flow_stride",flow_stride);
+				break;
+			case 'f':
+				event_window = atoi(optarg);
+				if(event_window > 64){
+					printf("Event window must be at most 64 samples\n");
+					exit(-1);
+				}
+				printf("Argument for event window is %d\n",event_window);
+				appendData(&params,"event_window",event_window);
+				break;
+			case 'q':
+				event_steps = atoi(optarg);
+				printf("Argument for event sampling steps is %d\n",event_steps);
+				appendData(&params,"event_steps",event_steps);
+				break;
+			case 'j':
+				event_jump = atof(optarg);
+				printf("Argument for event jump is %E\n",event_jump);
+				appendData(&params,"event_jump",event_jump);
+				break;
 			case 'D':
 				DX = atoi(optarg);
 				printf("Argument for DX is %d\n",DX);
@@ -964,17 +1496,33 @@ int main(int argc, char **argv){
 
 	initialise(omegaX,omegaY,atoms);
 	timeTotal = 0.0;
+	if(outPolFile[0] != '\0'){ //Regions are resolved against the grid, so read after initialise
+		numOutPol = FileIO::readOutPolicies(outPolFile, outPol, 16, xDim, yDim);
+		if(numOutPol < 0)
+			exit(1);
+	}
 	//************************************************************//
 	/*
 	* Groundstate finder section
 	*/
 	//************************************************************//
+	if(resume){ //Replaces wfc and the accumulated params with the checkpointed ones
+		if(FileIO::readCheckpoint("checkpoint.chk", chk, wfc, xDim, yDim, &chkVort, EV_opt, &params, &vortices, &chkSk) != 0)
+			exit(1);
+		printf("Checkpoint loaded at %s step %d.\n", chk.gstate ? "evolution" : "groundstate", chk.step);
+	}
 	FileIO::writeOutParam(buffer, params, "Params.dat");
-	if(read_wfc == 1){
+	if(read_wfc == 1 && !resume){
 		printf("Loading wavefunction...");
 		wfc=FileIO::readIn("wfc_load","wfci_load",xDim, yDim);
 		printf("Wavefunction loaded.\n");
 	}
+	else if(read_wfc == 2 && !resume){ //Binary snapshot, mapped straight into the wfc buffer
+		printf("Loading binary wavefunction...");
+		if(FileIO::readInBin("wfc_load.bin", wfc, xDim, yDim) == NULL)
+			exit(1);
+		printf("Wavefunction loaded.\n");
+	}
 	
 	double2 ph;
 	double x_0,y_0;
@@ -988,7 +1536,7 @@ int main(int argc, char **argv){
 		}
 	}
 	printf("l=%e\n",l);
-*/	if(gsteps > 0){
+*/	if(gsteps > 0 && !(resume && chk.gstate == 1)){
 		err=cudaMemcpy(K_gpu, GK, sizeof(cufftDoubleComplex)*xDim*yDim, cudaMemcpyHostToDevice);
 		if(err!=cudaSuccess)
 			exit(1);
@@ -36,6 +36,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../include/minions.h"
 #include "../include/constants.h"
 #include "../include/vort.h"
+#include <vector>
+#include <algorithm>
 
 /**
  *  Contains all the glorious info you need to track vortices and see what they are up to.
@@ -132,50 +134,74 @@ namespace Tracker {
 	}
 	#else 
 	/**
-	 * Phase winding method to determine vortex positions. Calculates the phase around a loop and checks if ~ +/-2Pi. 
+	 * Returns 1 if the phase of a lies in (0,pi], 0 if it lies in (-pi,0].
+	 */
+	static inline int upperHalf(double2 a){
+		return (a.y > 0.0) | ((a.y == 0.0) & (a.x < 0.0));
+	}
+
+	/**
+	 * Number of times the principal phase step from a to b crosses the branch
+	 * cut at pi: +1 anticlockwise, -1 clockwise, 0 otherwise. Summed around a
+	 * closed loop this gives the winding number without any atan2 calls.
+	 */
+	static inline int cutCrossing(double2 a, double2 b){
+		double c = a.x*b.y - a.y*b.x;
+		int ua = upperHalf(a), ub = upperHalf(b);
+		return (ua & (ub^1) & (c >= 0.0)) - ((ua^1) & ub & (c < 0.0));
+	}
+
+	/**
+	 * Winding number of the plaquette with lower corner (i,j), taken around
+	 * (i,j) -> (i+1,j) -> (i+1,j+1) -> (i,j+1). Positive for the same sense
+	 * as WFC::phaseWinding.
+	 */
+	static inline int plaquetteWinding(const double2 *wfc, int i, int j, int xDim){
+		double2 p0 = wfc[i*xDim + j], p1 = wfc[(i+1)*xDim + j];
+		double2 p2 = wfc[(i+1)*xDim + (j+1)], p3 = wfc[i*xDim + (j+1)];
+		return cutCrossing(p0,p1) + cutCrossing(p1,p2) + cutCrossing(p2,p3) + cutCrossing(p3,p0);
+	}
+
+	/**
+	 * Phase winding method to determine vortex positions. Every plaquette inside
+	 * the radius is evaluated independently, then hits sharing a sign with an
+	 * already visited neighbour (left, or any of the three above) are dropped
+	 * so a single core is not counted twice.
 	 */
 	int findVortex(int *marker, double2* wfc, double radius, int xDim, double *x, int timestep){
-			double2 *g = (double2*) malloc(sizeof(double2)*4);
-			double *phiDelta = (double*) malloc(sizeof(double)*4);
-		int i,j,found;
-		int cond_x, cond_y;
-		cond_x = 0; cond_y = 0;
-		found = 0;
-		long rnd_value = 0;
-		double sum = 0.0;
-			for ( i=0; i < xDim-1; ++i ){
-					for( j=0; j < xDim-1; ++j ){
-							if(sqrt(x[i]*x[i] + x[j]*x[j]) < radius){
-									g[0] = Minions::complexScale( Minions::complexDiv( wfc[i*xDim + j],     	wfc[(i+1)*xDim + j] ), 		( Minions::complexMag( wfc[(i+1)*xDim + j])		/ Minions::complexMag( wfc[i*xDim + j] )));
-									g[1] = Minions::complexScale( Minions::complexDiv( wfc[(i+1)*xDim + j], 	wfc[(i+1)*xDim + (j+1)] ), 	( Minions::complexMag( wfc[(i+1)*xDim + (j+1)])	/ Minions::complexMag( wfc[(i+1)*xDim + j] )));	
-									g[2] = Minions::complexScale( Minions::complexDiv( wfc[(i+1)*xDim + (j+1)],	wfc[i*xDim + (j+1)] ), 		( Minions::complexMag( wfc[i*xDim + (j+1)])		/ Minions::complexMag( wfc[(i+1)*xDim + (j+1)] )));		
-									g[3] = Minions::complexScale( Minions::complexDiv( wfc[i*xDim + (j+1)], 	wfc[i*xDim + j] ), 			( Minions::complexMag( wfc[i*xDim + j])			/ Minions::complexMag( wfc[i*xDim + (j+1)] )));
-					for (int k=0; k<4; ++k){
-						phiDelta[k] = atan2( g[k].y, g[k].x );
-						if(phiDelta[k] <= -PI){
-							phiDelta[k] += 2*PI;
-						}
-					}
-					sum = phiDelta[0] + phiDelta[1] + phiDelta[2] + phiDelta[3];
-					rnd_value = lround(sum/(2*PI));
-					if( sum >= 1.9*PI && cond_x <= 0 && cond_y <= 0){
-						marker[i*xDim + j] = rnd_value;
-						++found;
-						sum = 0.0;
-						cond_x = 2; cond_y = 2;
-									}
-					else if( sum <= -1.9*PI && cond_x <= 0 && cond_y <= 0 )  {
-						marker[i*xDim + j] = -rnd_value;
-						++found;
-						sum = 0.0;
-						cond_x = 2; cond_y = 2;
+		int n = xDim - 1;
+		double r2 = radius*radius;
+		signed char *w = (signed char*) calloc((size_t) xDim*xDim, sizeof(signed char));
+		int found = 0;
 
-					}
-					--cond_x;
-					--cond_y;
-							}
-					}
+		#pragma omp parallel for
+		for (int i=0; i < n; ++i){
+			double xi2 = x[i]*x[i];
+			signed char *row = w + (size_t) i*xDim;
+			#pragma omp simd
+			for (int j=0; j < n; ++j){
+				int inside = (xi2 + x[j]*x[j] < r2);
+				row[j] = inside ? plaquetteWinding(wfc, i, j, xDim) : 0;
 			}
+		}
+
+		#pragma omp parallel for reduction(+:found)
+		for (int i=0; i < n; ++i){
+			const signed char *row = w + (size_t) i*xDim;
+			const signed char *prev = (i > 0) ? row - xDim : NULL;
+			for (int j=0; j < n; ++j){
+				int wind = row[j];
+				if (wind == 0)
+					continue;
+				if (j > 0 && row[j-1] == wind)
+					continue;
+				if (prev && (prev[j] == wind || (j > 0 && prev[j-1] == wind) || (j < n-1 && prev[j+1] == wind)))
+					continue;
+				marker[i*xDim + j] = wind;
+				++found;
+			}
+		}
+		free(w);
 		return found;
 	}
 	#endif
@@ -228,29 +254,41 @@ namespace Tracker {
 	 * Accepts matrix of vortex locations as argument, returns array of x,y coordinates of locations and first encountered vortex angle 
 	 */
 	void vortPos(int *marker, struct Vtx::Vortex *vLocation, int xDim, double2 *wfc){
-		int i,j;
-		unsigned int counter=0;
-		for(i=0; i<xDim; ++i){
-			for(j=0; j<xDim; ++j){
-				if( abs((marker)[i*xDim + j]) >= 1){
-					(vLocation)[ counter ].coords.x=i;
-					(vLocation)[ counter ].coords.y=j;
-					//(vLocation)[ counter ].sign = ( signbit(abs(marker[i*xDim + j])) == 0 ) ? 1 : -1;
-					(vLocation)[ counter ].wind = (marker[i*xDim + j]);
+		int *offset = (int*) calloc(xDim+1, sizeof(int));
+
+		#pragma omp parallel for
+		for(int i=0; i<xDim; ++i){
+			int count = 0;
+			for(int j=0; j<xDim; ++j)
+				count += (marker[i*xDim + j] != 0);
+			offset[i+1] = count;
+		}
+		for(int i=0; i<xDim; ++i)
+			offset[i+1] += offset[i];
+
+		#pragma omp parallel for
+		for(int i=0; i<xDim; ++i){
+			int counter = offset[i];
+			for(int j=0; j<xDim; ++j){
+				if(marker[i*xDim + j] != 0){
+					vLocation[counter].coords.x=i;
+					vLocation[counter].coords.y=j;
+					vLocation[counter].wind = marker[i*xDim + j];
 					++counter;
 				}
 			}
 		}
+		free(offset);
 	}
 
 	/**
 	 * Ensures the vortices are tracked and arranged in the right order based on minimum distance between previous and current positions
 	 */
 	void vortArrange(struct Vtx::Vortex *vCoordsC, struct Vtx::Vortex *vCoordsP, int length){
-		int dist, dist_t;
+		double dist, dist_t;
 		int i, j, index;
 		for ( i = 0; i < length; ++i ){
-			dist = 0x7FFFFFFF; //arbitrary big value
+			dist = 1e300; //arbitrary big value
 			index = i;
 			for ( j = i; j < length ; ++j){
 				dist_t = ( (vCoordsP[i].coordsD.x - vCoordsC[j].coordsD.x)*(vCoordsP[i].coordsD.x - vCoordsC[j].coordsD.x) + (vCoordsP[i].coordsD.y - vCoordsC[j].coordsD.y)*(vCoordsP[i].coordsD.y - vCoordsC[j].coordsD.y) );
@@ -320,35 +358,232 @@ namespace Tracker {
 	}
 
 	/**
-	 * Performs least squares fitting to get exact vortex core position.
+	 * Performs least squares fitting to get exact vortex core position. A
+	 * plane a + b*dx + c*dy is fitted to the stencil x stencil points around
+	 * each core and its zero solved for. The 4x4 stencil averages out noise
+	 * in well resolved cores; odd stencils would sit off the plaquette centre
+	 * and bias the fit, so are not offered. Stencils are gathered a block of
+	 * vortices at a time into contiguous arrays, and the fit and solve then
+	 * vectorise across the block.
 	 */
-    void lsFit(struct Vtx::Vortex *vortCoords, double2 *wfc, int numVort, int xDim){
-		double2 *wfc_grid = (double2*) malloc(sizeof(double2)*4);
-		double2 *res = (double2*) malloc(sizeof(double2)*3);
-		double2 X;
-		double det=0.0;
-		for(int ii=0; ii<numVort; ++ii){
-			vortCoords[ii].coordsD.x = 0.0; vortCoords[ii].coordsD.y = 0.0;
-
-			wfc_grid[0] = wfc[vortCoords[ii].coords.x*xDim + vortCoords[ii].coords.y];
-			wfc_grid[1] = wfc[(vortCoords[ii].coords.x + 1)*xDim + vortCoords[ii].coords.y];
-			wfc_grid[2] = wfc[vortCoords[ii].coords.x*xDim + (vortCoords[ii].coords.y + 1)];
-			wfc_grid[3] = wfc[(vortCoords[ii].coords.x + 1)*xDim + (vortCoords[ii].coords.y + 1)];
-
-			for(int jj=0; jj<3; ++jj) {
-				res[jj].x = lsq[jj][0]*wfc_grid[0].x + lsq[jj][1]*wfc_grid[1].x + lsq[jj][2]*wfc_grid[2].x + lsq[jj][3]*wfc_grid[3].x;
-				res[jj].y = lsq[jj][0]*wfc_grid[0].y + lsq[jj][1]*wfc_grid[1].y + lsq[jj][2]*wfc_grid[2].y + lsq[jj][3]*wfc_grid[3].y;
+	void lsFit(struct Vtx::Vortex *vortCoords, double2 *wfc, int numVort, int xDim, int stencil){
+		const int B = 128;
+		int S = (stencil == 4) ? 4 : 2;
+		int o0 = -(S - 1)/2; //First stencil offset, centring the stencil on the plaquette
+		double m = o0 + 0.5*(S - 1); //Stencil centre
+		double sxx = 0.0, w[4];
+		for(int k = 0; k < S; ++k)
+			sxx += S*(o0 + k - m)*(o0 + k - m);
+		for(int k = 0; k < S; ++k)
+			w[k] = (o0 + k - m)/sxx;
+
+		#pragma omp parallel for schedule(dynamic)
+		for(int n0 = 0; n0 < numVort; n0 += B){
+			int nb = (numVort - n0 < B) ? numVort - n0 : B;
+			double re[16][B], im[16][B];
+			double bx[B], by[B], cx[B], cy[B], ax[B], ay[B];
+			for(int n = 0; n < nb; ++n){
+				int i = vortCoords[n0 + n].coords.x + o0, j = vortCoords[n0 + n].coords.y + o0;
+				for(int a = 0; a < S; ++a){
+					int ia = std::min(std::max(i + a, 0), xDim - 1);
+					for(int c = 0; c < S; ++c){
+						double2 v = wfc[ia*xDim + std::min(std::max(j + c, 0), xDim - 1)];
+						re[a*S + c][n] = v.x;
+						im[a*S + c][n] = v.y;
+					}
+				}
+			}
+			#pragma omp simd
+			for(int n = 0; n < nb; ++n){
+				bx[n] = 0.0; by[n] = 0.0; cx[n] = 0.0; cy[n] = 0.0; ax[n] = 0.0; ay[n] = 0.0;
+			}
+			for(int a = 0; a < S; ++a){
+				for(int c = 0; c < S; ++c){
+					const double *pr = re[a*S + c], *pi = im[a*S + c];
+					double wa = w[a], wc = w[c];
+					#pragma omp simd
+					for(int n = 0; n < nb; ++n){
+						bx[n] += wa*pr[n]; by[n] += wa*pi[n];
+						cx[n] += wc*pr[n]; cy[n] += wc*pi[n];
+						ax[n] += pr[n];    ay[n] += pi[n];
+					}
+				}
+			}
+			//Solve [b c][X Y]^T = -a, with a the mean over the stencil
+			double inv = 1.0/(S*S);
+			#pragma omp simd
+			for(int n = 0; n < nb; ++n){
+				double det = 1.0/(bx[n]*cy[n] - cx[n]*by[n]);
+				double X = det*(cx[n]*ay[n] - cy[n]*ax[n])*inv;
+				double Y = det*(by[n]*ax[n] - bx[n]*ay[n])*inv;
+				ax[n] = X + m;
+				ay[n] = Y + m;
 			}
+			for(int n = 0; n < nb; ++n){
+				vortCoords[n0 + n].coordsD.x = vortCoords[n0 + n].coords.x + ax[n];
+				vortCoords[n0 + n].coordsD.y = vortCoords[n0 + n].coords.y + ay[n];
+			}
+		}
+	}
+
+	/**
+	 * Minimum cost assignment on an n*n row-major cost matrix (Hungarian
+	 * method with potentials). Returns the column assigned to each row.
+	 */
+	static std::vector<int> assign(const std::vector<double> &cost, int n){
+		const double inf = 1e300;
+		std::vector<double> u(n+1, 0.0), v(n+1, 0.0), minv(n+1);
+		std::vector<int> p(n+1, 0), way(n+1, 0), rowCol(n);
+		std::vector<char> used(n+1);
+		for(int i = 1; i <= n; ++i){
+			p[0] = i;
+			int j0 = 0;
+			std::fill(minv.begin(), minv.end(), inf);
+			std::fill(used.begin(), used.end(), 0);
+			do{
+				used[j0] = 1;
+				int i0 = p[j0], j1 = 0;
+				double delta = inf;
+				for(int j = 1; j <= n; ++j){
+					if(used[j])
+						continue;
+					double cur = cost[(i0-1)*n + (j-1)] - u[i0] - v[j];
+					if(cur < minv[j]){
+						minv[j] = cur;
+						way[j] = j0;
+					}
+					if(minv[j] < delta){
+						delta = minv[j];
+						j1 = j;
+					}
+				}
+				for(int j = 0; j <= n; ++j){
+					if(used[j]){
+						u[p[j]] += delta;
+						v[j] -= delta;
+					}
+					else
+						minv[j] -= delta;
+				}
+				j0 = j1;
+			} while(p[j0] != 0);
+			do{
+				int j1 = way[j0];
+				p[j0] = p[j1];
+				j0 = j1;
+			} while(j0);
+		}
+		for(int j = 1; j <= n; ++j)
+			rowCol[p[j]-1] = j-1;
+		return rowCol;
+	}
+
+	static int findRoot(std::vector<int> &parent, int a){
+		while(parent[a] != a)
+			a = parent[a] = parent[parent[a]];
+		return a;
+	}
 
-			//Solve Ax=b here. A = res[0,1], b = - res[2]. Solution -> X
-			det = 1.0/(res[0].x*res[1].y - res[0].y*res[1].x);
-			X.x = det*(res[1].y*res[2].x - res[0].y*res[2].y);
-			X.y = det*(-res[1].x*res[2].x + res[0].x*res[2].y);
+	/**
+	 * Links the current vortices to the previous frame and carries over their
+	 * UIDs. Current vortices are hashed into cells of side gate, so each
+	 * previous vortex only compares against the 3x3 cells around it. Candidate
+	 * pairs (same winding, within gate) split into independent clusters, and
+	 * each cluster is solved exactly by minimum total squared displacement,
+	 * where leaving a vortex unmatched costs gate^2. Unmatched current vortices
+	 * are births and get new UIDs. Unmatched previous vortices have died.
+	 */
+	int linkVortices(struct Vtx::Vortex *vPrev, int numPrev, struct Vtx::Vortex *vCur, int numCur, double gate, unsigned int *nextUid){
+		const double big = 1e30;
+		double gate2 = gate*gate;
+		int linked = 0;
+		std::vector<int> match(numCur, -1);
 
-			vortCoords[ii].coordsD.x = vortCoords[ii].coords.x - X.x;
-			vortCoords[ii].coordsD.y = vortCoords[ii].coords.y - X.y;
+		//Grid hash of current vortices, sorted by cell key
+		std::vector< std::pair<unsigned long long,int> > cells(numCur);
+		auto key = [gate](double cx, double cy, int dx, int dy){ //Shifted as unsigned, since kx is -1 beside the x=0 edge
+			long long kx = (long long) floor(cx/gate) + dx, ky = (long long) floor(cy/gate) + dy;
+			return ((unsigned long long) kx << 32) ^ (unsigned int) ky;
+		};
+		for(int c = 0; c < numCur; ++c)
+			cells[c] = std::make_pair(key(vCur[c].coordsD.x, vCur[c].coordsD.y, 0, 0), c);
+		std::sort(cells.begin(), cells.end());
+
+		//Candidate pairs and clusters. Nodes are previous [0,numPrev) then current.
+		std::vector<int> parent(numPrev + numCur);
+		for(size_t a = 0; a < parent.size(); ++a)
+			parent[a] = a;
+		std::vector< std::pair<int,int> > pairs;
+		for(int p = 0; p < numPrev; ++p){
+			for(int dx = -1; dx <= 1; ++dx){
+				for(int dy = -1; dy <= 1; ++dy){
+					unsigned long long k = key(vPrev[p].coordsD.x, vPrev[p].coordsD.y, dx, dy);
+					auto it = std::lower_bound(cells.begin(), cells.end(), std::make_pair(k, -1));
+					for(; it != cells.end() && it->first == k; ++it){
+						int c = it->second;
+						double ddx = vPrev[p].coordsD.x - vCur[c].coordsD.x;
+						double ddy = vPrev[p].coordsD.y - vCur[c].coordsD.y;
+						if(vPrev[p].wind != vCur[c].wind || ddx*ddx + ddy*ddy > gate2)
+							continue;
+						pairs.push_back(std::make_pair(p, c));
+						parent[findRoot(parent, p)] = findRoot(parent, numPrev + c);
+					}
+				}
+			}
 		}
-    }
+
+		//Solve each cluster with both previous and current members
+		std::vector< std::vector<int> > members(numPrev + numCur);
+		for(int a = 0; a < numPrev + numCur; ++a)
+			members[findRoot(parent, a)].push_back(a);
+		std::vector<int> local(numPrev + numCur, -1);
+		std::vector< std::vector< std::pair<int,int> > > clusterPairs(numPrev + numCur);
+		for(size_t e = 0; e < pairs.size(); ++e)
+			clusterPairs[findRoot(parent, pairs[e].first)].push_back(pairs[e]);
+		for(int r = 0; r < numPrev + numCur; ++r){
+			if(clusterPairs[r].empty())
+				continue;
+			std::vector<int> ps, cs;
+			for(size_t m = 0; m < members[r].size(); ++m){
+				int a = members[r][m];
+				if(a < numPrev){
+					local[a] = ps.size();
+					ps.push_back(a);
+				}
+				else{
+					local[a] = cs.size();
+					cs.push_back(a - numPrev);
+				}
+			}
+			int np = ps.size(), nc = cs.size(), n = np + nc;
+			std::vector<double> cost((size_t) n*n, big);
+			for(int a = 0; a < np; ++a)
+				cost[a*n + nc + a] = gate2; //Death
+			for(int b = 0; b < nc; ++b)
+				cost[(np + b)*n + b] = gate2; //Birth
+			for(int a = np; a < n; ++a)
+				for(int b = nc; b < n; ++b)
+					cost[a*n + b] = 0.0;
+			for(size_t e = 0; e < clusterPairs[r].size(); ++e){
+				int p = clusterPairs[r][e].first, c = clusterPairs[r][e].second;
+				double ddx = vPrev[p].coordsD.x - vCur[c].coordsD.x;
+				double ddy = vPrev[p].coordsD.y - vCur[c].coordsD.y;
+				cost[local[p]*n + local[numPrev + c]] = ddx*ddx + ddy*ddy;
+			}
+			std::vector<int> rowCol = assign(cost, n);
+			for(int a = 0; a < np; ++a){
+				int b = rowCol[a];
+				if(b < nc && cost[a*n + b] < big){
+					match[cs[b]] = ps[a];
+					++linked;
+				}
+			}
+		}
+
+		for(int c = 0; c < numCur; ++c)
+			vCur[c].uid = (match[c] >= 0) ? vPrev[match[c]].uid : (*nextUid)++;
+		return linked;
+	}
 
 	/*
 	void trackVortices(Vtx::VtxList &vorticesC, Vtx::VtxList &vorticesP){
@@ -0,0 +1,433 @@
+/*** trajfile.cc - GPUE: Split Operator based GPU solver for Nonlinear
+Schrodinger Equation, Copyright (C) 2011-2015, Lee J. O'Riordan
+<loriordan@gmail.com>, Tadhg Morgan, Neil Crowley.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its
+contributors may be used to endorse or promote products derived from
+this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <limits.h>
+#include <algorithm>
+#include "../include/trajfile.h"
+
+namespace TrajFile {
+
+	static void putVarint(std::vector<unsigned char> &buf, unsigned long long v){
+		while(v >= 0x80){
+			buf.push_back((unsigned char)(v | 0x80));
+			v >>= 7;
+		}
+		buf.push_back((unsigned char) v);
+	}
+
+	static unsigned long long getVarint(const unsigned char *&p, const unsigned char *end){
+		unsigned long long v = 0;
+		for(int shift = 0; p < end && shift < 64; shift += 7){
+			unsigned char c = *p++;
+			v |= (unsigned long long)(c & 0x7f) << shift;
+			if(!(c & 0x80))
+				break;
+		}
+		return v;
+	}
+
+	static unsigned long long zigzag(long long v){
+		return ((unsigned long long) v << 1) ^ (unsigned long long)(v >> 63);
+	}
+
+	static long long unzigzag(unsigned long long v){
+		return (long long)(v >> 1) ^ -(long long)(v & 1);
+	}
+
+	static bool byUid(const Record &a, const Record &b){
+		return a.uid < b.uid;
+	}
+
+	/*
+	 * Reads the block header at off. Returns false at the end of the blocks:
+	 * a short read, a different tag, or a payload running past the file end.
+	 */
+	static bool readHeader(FILE *f, long long off, long long fileLen, BlockHeader &bh){
+		if(fseeko(f, off, SEEK_SET) != 0 || fread(&bh, sizeof(BlockHeader), 1, f) != 1)
+			return false;
+		return strncmp(bh.tag,"BLK0",4) == 0 && off + (long long) sizeof(BlockHeader) + bh.numBytes <= fileLen;
+	}
+
+	/*
+	 * Decodes the block at off, appending its records to out. Each column is
+	 * decoded in turn; the step and position columns restart at the first
+	 * record of each uid.
+	 */
+	static int decodeBlock(FILE *f, long long off, const BlockHeader &bh, double scale, std::vector<Record> &out){
+		std::vector<unsigned char> buf(bh.numBytes);
+		if(fseeko(f, off + sizeof(BlockHeader), SEEK_SET) != 0 || fread(buf.data(), 1, bh.numBytes, f) != bh.numBytes)
+			return -1;
+		const unsigned char *p = buf.data(), *end = p + buf.size();
+		size_t base = out.size();
+		out.resize(base + bh.numRec);
+		Record *r = &out[base];
+		unsigned int uid = 0;
+		for(unsigned int i = 0; i < bh.numRec; ++i){
+			uid += (unsigned int) getVarint(p, end);
+			r[i].uid = uid;
+		}
+		for(unsigned int i = 0; i < bh.numRec; ++i){
+			bool first = (i == 0 || r[i].uid != r[i-1].uid);
+			r[i].step = (first ? bh.stepMin : r[i-1].step) + (int) getVarint(p, end);
+		}
+		long long q = 0;
+		for(unsigned int i = 0; i < bh.numRec; ++i){
+			q = ((i == 0 || r[i].uid != r[i-1].uid) ? 0 : q) + unzigzag(getVarint(p, end));
+			r[i].x = q/scale;
+		}
+		for(unsigned int i = 0; i < bh.numRec; ++i){
+			q = ((i == 0 || r[i].uid != r[i-1].uid) ? 0 : q) + unzigzag(getVarint(p, end));
+			r[i].y = q/scale;
+		}
+		for(unsigned int i = 0; i < bh.numRec; ++i)
+			r[i].wind = (int) unzigzag(getVarint(p, end));
+		if(p != end){
+			out.resize(base);
+			return -1;
+		}
+		return 0;
+	}
+
+	static void indexBlock(std::vector<std::vector<unsigned int> > &blocksOfUid, const Record *r, size_t num, unsigned int b){
+		for(size_t i = 0; i < num; ++i){
+			if(i > 0 && r[i].uid == r[i-1].uid)
+				continue;
+			if(r[i].uid >= blocksOfUid.size())
+				blocksOfUid.resize(r[i].uid + 1);
+			blocksOfUid[r[i].uid].push_back(b);
+		}
+	}
+
+//######################################################################################################################
+
+	Writer::Writer() : f(NULL), scale(1048576.0), blockLen(8192){
+	}
+
+	Writer::~Writer(){
+		if(f != NULL)
+			close();
+	}
+
+	/*
+	 * Blocks that end before fromStep are kept and re-indexed. The first block
+	 * reaching fromStep and everything after it (including an old index) is
+	 * cut off, and the samples of that block still before fromStep go back to
+	 * the pending buffer.
+	 */
+	int Writer::open(char *file, int fromStep, int blockLen){
+		this->blockLen = (blockLen < 1) ? 8192 : blockLen;
+		pending.clear();
+		offsets.clear();
+		blocksOfUid.clear();
+		TrajHeader h;
+		f = (fromStep < 0) ? NULL : fopen(file,"rb+");
+		if(f != NULL){
+			if(fread(&h, sizeof(TrajHeader), 1, f) != 1 || strncmp(h.magic,"GPUT",4) != 0 || h.version != 1){
+				fprintf(stderr,"%s is not a trajectory file\n",file);
+				fclose(f);
+				f = NULL;
+				return -1;
+			}
+			scale = h.scale;
+			fseeko(f, 0, SEEK_END);
+			long long fileLen = ftello(f);
+			long long off = sizeof(TrajHeader);
+			BlockHeader bh;
+			std::vector<Record> recs;
+			while(readHeader(f, off, fileLen, bh) && bh.stepMax < fromStep){
+				recs.clear();
+				if(decodeBlock(f, off, bh, scale, recs) != 0)
+					break;
+				indexBlock(blocksOfUid, recs.data(), recs.size(), offsets.size());
+				offsets.push_back(off);
+				off += sizeof(BlockHeader) + bh.numBytes;
+			}
+			if(readHeader(f, off, fileLen, bh) && bh.stepMin < fromStep){
+				recs.clear();
+				decodeBlock(f, off, bh, scale, recs);
+				for(size_t i = 0; i < recs.size(); ++i)
+					if(recs[i].step < fromStep)
+						pending.push_back(recs[i]);
+				std::stable_sort(pending.begin(), pending.end(), [](const Record &a, const Record &b){ return a.step < b.step; });
+			}
+			fflush(f);
+			if(ftruncate(fileno(f), off) != 0 || fseeko(f, off, SEEK_SET) != 0){
+				fprintf(stderr,"Cannot truncate %s\n",file);
+				fclose(f);
+				f = NULL;
+				return -1;
+			}
+			return 0;
+		}
+		f = fopen(file,"wb");
+		if(f == NULL){
+			fprintf(stderr,"Cannot create %s\n",file);
+			return -1;
+		}
+		memcpy(h.magic,"GPUT",4);
+		h.version = 1;
+		h.scale = scale;
+		fwrite(&h, sizeof(TrajHeader), 1, f);
+		return 0;
+	}
+
+	bool Writer::isOpen(){
+		return f != NULL;
+	}
+
+	void Writer::append(const Vtx::Vortex *v, int num, int step){
+		if(f == NULL)
+			return;
+		for(int k = 0; k < num; ++k){
+			Record r;
+			r.uid = v[k].uid;
+			r.step = step;
+			r.x = v[k].coordsD.x;
+			r.y = v[k].coordsD.y;
+			r.wind = v[k].wind;
+			pending.push_back(r);
+			if((int) pending.size() >= blockLen)
+				flush();
+		}
+	}
+
+	/*
+	 * Samples arrive in step order, so a stable sort on uid leaves each
+	 * vortex's samples contiguous and in step order.
+	 */
+	void Writer::flush(){
+		if(pending.empty())
+			return;
+		std::stable_sort(pending.begin(), pending.end(), byUid);
+		size_t n = pending.size();
+		const Record *r = pending.data();
+		BlockHeader bh;
+		memcpy(bh.tag,"BLK0",4);
+		bh.numRec = n;
+		bh.uidMin = r[0].uid;
+		bh.uidMax = r[n-1].uid;
+		bh.stepMin = r[0].step;
+		bh.stepMax = r[0].step;
+		for(size_t i = 1; i < n; ++i){
+			bh.stepMin = std::min(bh.stepMin, r[i].step);
+			bh.stepMax = std::max(bh.stepMax, r[i].step);
+		}
+
+		std::vector<unsigned char> buf;
+		buf.reserve(8*n);
+		for(size_t i = 0; i < n; ++i)
+			putVarint(buf, r[i].uid - (i == 0 ? 0 : r[i-1].uid));
+		for(size_t i = 0; i < n; ++i){
+			bool first = (i == 0 || r[i].uid != r[i-1].uid);
+			putVarint(buf, r[i].step - (first ? bh.stepMin : r[i-1].step));
+		}
+		for(int c = 0; c < 2; ++c){
+			long long prev = 0;
+			for(size_t i = 0; i < n; ++i){
+				long long q = llround((c == 0 ? r[i].x : r[i].y)*scale);
+				putVarint(buf, zigzag(q - ((i == 0 || r[i].uid != r[i-1].uid) ? 0 : prev)));
+				prev = q;
+			}
+		}
+		for(size_t i = 0; i < n; ++i)
+			putVarint(buf, zigzag(r[i].wind));
+		bh.numBytes = buf.size();
+
+		indexBlock(blocksOfUid, r, n, offsets.size());
+		offsets.push_back(ftello(f));
+		fwrite(&bh, sizeof(BlockHeader), 1, f);
+		fwrite(buf.data(), 1, buf.size(), f);
+		pending.clear();
+	}
+
+	int Writer::close(){
+		if(f == NULL)
+			return -1;
+		flush();
+		TrajTrailer t;
+		t.indexOffset = ftello(f);
+		memcpy(t.magic,"GPUI",4);
+		t.reserved = 0;
+		unsigned int numBlocks = offsets.size(), uidBound = blocksOfUid.size();
+		fwrite("IDX0", 1, 4, f);
+		fwrite(&numBlocks, sizeof(unsigned int), 1, f);
+		fwrite(offsets.data(), sizeof(long long), numBlocks, f);
+		fwrite(&uidBound, sizeof(unsigned int), 1, f);
+		for(unsigned int u = 0; u < uidBound; ++u){
+			unsigned int count = blocksOfUid[u].size();
+			fwrite(&count, sizeof(unsigned int), 1, f);
+			fwrite(blocksOfUid[u].data(), sizeof(unsigned int), count, f);
+		}
+		fwrite(&t, sizeof(TrajTrailer), 1, f);
+		int err = fclose(f);
+		f = NULL;
+		if(err != 0){
+			fprintf(stderr,"Cannot write trajectory file\n");
+			return -1;
+		}
+		return 0;
+	}
+
+//######################################################################################################################
+
+	/*
+	 * A closed file is read through its index. Otherwise the blocks are walked
+	 * by their headers alone, and lookups fall back to the block uid ranges.
+	 */
+	Reader::Reader(char *file){
+		f = fopen(file,"rb");
+		if(f == NULL)
+			return;
+		if(fread(&h, sizeof(TrajHeader), 1, f) != 1 || strncmp(h.magic,"GPUT",4) != 0 || h.version != 1){
+			fclose(f);
+			f = NULL;
+			return;
+		}
+		fseeko(f, 0, SEEK_END);
+		long long fileLen = ftello(f);
+		TrajTrailer t;
+		bool indexed = false;
+		if(fileLen >= (long long)(sizeof(TrajHeader) + sizeof(TrajTrailer)) && fseeko(f, fileLen - sizeof(TrajTrailer), SEEK_SET) == 0
+		   && fread(&t, sizeof(TrajTrailer), 1, f) == 1 && strncmp(t.magic,"GPUI",4) == 0 && fseeko(f, t.indexOffset, SEEK_SET) == 0){
+			char tag[4];
+			unsigned int numBlocks = 0, uidBound = 0;
+			indexed = fread(tag, 1, 4, f) == 4 && strncmp(tag,"IDX0",4) == 0 && fread(&numBlocks, sizeof(unsigned int), 1, f) == 1;
+			if(indexed){
+				offsets.resize(numBlocks);
+				indexed = fread(offsets.data(), sizeof(long long), numBlocks, f) == numBlocks
+				          && fread(&uidBound, sizeof(unsigned int), 1, f) == 1;
+			}
+			if(indexed){
+				blocksOfUid.resize(uidBound);
+				for(unsigned int u = 0; u < uidBound && indexed; ++u){
+					unsigned int count = 0;
+					indexed = fread(&count, sizeof(unsigned int), 1, f) == 1;
+					blocksOfUid[u].resize(count);
+					indexed = indexed && fread(blocksOfUid[u].data(), sizeof(unsigned int), count, f) == count;
+				}
+			}
+			for(size_t b = 0; b < offsets.size() && indexed; ++b){
+				BlockHeader bh;
+				indexed = readHeader(f, offsets[b], fileLen, bh);
+				headers.push_back(bh);
+			}
+		}
+		if(!indexed){
+			offsets.clear();
+			headers.clear();
+			blocksOfUid.clear();
+			long long off = sizeof(TrajHeader);
+			BlockHeader bh;
+			while(readHeader(f, off, fileLen, bh)){
+				offsets.push_back(off);
+				headers.push_back(bh);
+				off += sizeof(BlockHeader) + bh.numBytes;
+			}
+		}
+	}
+
+	Reader::~Reader(){
+		if(f != NULL)
+			fclose(f);
+	}
+
+	bool Reader::isOpen(){
+		return f != NULL;
+	}
+
+	int Reader::getBlocks(){
+		return offsets.size();
+	}
+
+	unsigned int Reader::getUidBound(){
+		if(!blocksOfUid.empty())
+			return blocksOfUid.size();
+		unsigned int bound = 0;
+		for(size_t b = 0; b < headers.size(); ++b)
+			bound = std::max(bound, headers[b].uidMax + 1);
+		return bound;
+	}
+
+	int Reader::readBlock(int b, std::vector<Record> &out){
+		return decodeBlock(f, offsets[b], headers[b], h.scale, out);
+	}
+
+	int Reader::getTrajectory(unsigned int uid, std::vector<Record> &out){
+		out.clear();
+		std::vector<unsigned int> blocks;
+		if(!blocksOfUid.empty()){
+			if(uid < blocksOfUid.size())
+				blocks = blocksOfUid[uid];
+		}
+		else{
+			for(size_t b = 0; b < headers.size(); ++b)
+				if(headers[b].uidMin <= uid && uid <= headers[b].uidMax)
+					blocks.push_back(b);
+		}
+		std::vector<Record> recs;
+		for(size_t k = 0; k < blocks.size(); ++k){
+			recs.clear();
+			if(readBlock(blocks[k], recs) != 0)
+				return -1;
+			std::vector<Record>::iterator lo = std::lower_bound(recs.begin(), recs.end(), Record{uid, 0, 0, 0, 0}, byUid);
+			std::vector<Record>::iterator hi = std::upper_bound(lo, recs.end(), Record{uid, 0, 0, 0, 0}, byUid);
+			out.insert(out.end(), lo, hi);
+		}
+		return out.size();
+	}
+
+	int Reader::getAll(std::vector<Record> &out){
+		out.clear();
+		for(size_t b = 0; b < offsets.size(); ++b)
+			if(readBlock(b, out) != 0)
+				return -1;
+		return out.size();
+	}
+
+	int Reader::getBlock(int b, std::vector<Record> &out){
+		if(b < 0 || b >= (int) offsets.size())
+			return -1;
+		return readBlock(b, out);
+	}
+
+	int Reader::getStepMin(int b){
+		if(b < 0 || b >= (int) headers.size())
+			return INT_MAX;
+		return headers[b].stepMin;
+	}
+}
@@ -32,41 +32,197 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include "../include/vort.h"
 
-//@todo Implemet this
 namespace Vtx {
 
 //######################################################################################################################
 //######################################################################################################################
 
-    std::list<std::shared_ptr<Vortex> > &VtxList::getVortices(){
+    VtxList::VtxList() : updates(0), born(0), died(0), maxUid(0) {
+    }
+
+    void VtxList::update(const Vortex *v, int num, int step){
+        ++updates;
+        born = 0;
+        died = 0;
+        for(int k = 0; k < num; ++k){
+            unsigned int u = v[k].uid;
+            if(u >= slotOfUid.size())
+                slotOfUid.resize(2*(size_t)u + 1, -1);
+            int s = slotOfUid[u];
+            if(s < 0){ //Birth
+                s = uid.size();
+                slotOfUid[u] = s;
+                coords.push_back(v[k].coords);
+                coordsD.push_back(v[k].coordsD);
+                wind.push_back(v[k].wind);
+                uid.push_back(u);
+                active.push_back(1);
+                birth.push_back(step);
+                death.push_back(-1);
+                seen.push_back(0);
+                maxUid = (u > maxUid) ? u : maxUid;
+                ++born;
+            }
+            else{
+                coords[s] = v[k].coords;
+                coordsD[s] = v[k].coordsD;
+                wind[s] = v[k].wind;
+                if(!active[s]){ //Reappeared under the same UID
+                    active[s] = 1;
+                    death[s] = -1;
+                }
+            }
+            seen[s] = updates;
+        }
+        for(size_t a = 0; a < activeSlots.size(); ++a){
+            int s = activeSlots[a];
+            if(active[s] && seen[s] != updates){
+                active[s] = 0;
+                death[s] = step;
+                ++died;
+            }
+        }
+        activeSlots.clear();
+        for(int k = 0; k < num; ++k)
+            activeSlots.push_back(slotOfUid[v[k].uid]);
+    }
 
+    int VtxList::size() const{
+        return uid.size();
     }
 
-    std::shared_ptr<Vortex> VtxList::get_Uid(){
+    int VtxList::numActive() const{
+        return activeSlots.size();
+    }
+
+    void VtxList::lastChanges(int &b, int &d) const{
+        b = born;
+        d = died;
+    }
 
+    Vortex VtxList::get_Uid(unsigned int u) const{
+        return get_Idx(slotOfUid[u]);
     }
 
-    std::shared_ptr<Vortex> VtxList::get_Idx(){
+    Vortex VtxList::get_Idx(int idx) const{
+        Vortex v;
+        v.coords = coords[idx];
+        v.coordsD = coordsD[idx];
+        v.wind = wind[idx];
+        v.uid = uid[idx];
+        return v;
+    }
 
+    int VtxList::getIdx_Uid(unsigned int u) const{
+        return (u < slotOfUid.size()) ? slotOfUid[u] : -1;
     }
 
-    unsigned int VtxList::getIdx_Uid(){
+    unsigned int VtxList::getMax_Uid() const{
+        return maxUid;
+    }
 
+    int VtxList::getIdx_MinDist(const Vortex &v) const{
+        int best = -1;
+        double dist = 1e300;
+        for(size_t a = 0; a < activeSlots.size(); ++a){
+            int s = activeSlots[a];
+            double dx = coordsD[s].x - v.coordsD.x, dy = coordsD[s].y - v.coordsD.y;
+            if(dx*dx + dy*dy < dist){
+                dist = dx*dx + dy*dy;
+                best = s;
+            }
+        }
+        return best;
     }
 
-    unsigned int VtxList::getMax_Uid(){
+    void VtxList::swapUid(unsigned int u1, unsigned int u2){
+        int s1 = getIdx_Uid(u1), s2 = getIdx_Uid(u2);
+        if(s1 < 0 || s2 < 0)
+            return;
+        uid[s1] = u2;
+        uid[s2] = u1;
+        slotOfUid[u1] = s2;
+        slotOfUid[u2] = s1;
+    }
 
+    void VtxList::vortOff(unsigned int u, int step){
+        int s = getIdx_Uid(u);
+        if(s < 0 || !active[s])
+            return;
+        active[s] = 0;
+        death[s] = step;
+        for(size_t a = 0; a < activeSlots.size(); ++a){
+            if(activeSlots[a] == s){
+                activeSlots.erase(activeSlots.begin() + a);
+                break;
+            }
+        }
     }
 
-    unsigned int VtxList::getIdx_MinDist(){
+    bool VtxList::isActive(int idx) const{
+        return active[idx] != 0;
+    }
 
+    int VtxList::getBirth(int idx) const{
+        return birth[idx];
     }
 
-    void VtxList::swapUid(std::shared_ptr<Vortex> v1, std::shared_ptr<Vortex> v2){
+    int VtxList::getDeath(int idx) const{
+        return death[idx];
+    }
 
+    int VtxList::getActive(Vortex *out, int cap) const{
+        int n = activeSlots.size();
+        for(int a = 0; a < n && a < cap; ++a)
+            out[a] = get_Idx(activeSlots[a]);
+        return n;
     }
 
-    void VtxList::vortOff(){
+    int VtxList::write(FILE *f) const{
+        int n = uid.size(), na = activeSlots.size();
+        int ok = fwrite(&n, sizeof(int), 1, f) == 1 && fwrite(&na, sizeof(int), 1, f) == 1;
+        ok = ok && fwrite(&maxUid, sizeof(unsigned int), 1, f) == 1;
+        if(n > 0){
+            ok = ok && fwrite(&coords[0], sizeof(int2), n, f) == (size_t) n;
+            ok = ok && fwrite(&coordsD[0], sizeof(double2), n, f) == (size_t) n;
+            ok = ok && fwrite(&wind[0], sizeof(int), n, f) == (size_t) n;
+            ok = ok && fwrite(&uid[0], sizeof(unsigned int), n, f) == (size_t) n;
+            ok = ok && fwrite(&active[0], sizeof(char), n, f) == (size_t) n;
+            ok = ok && fwrite(&birth[0], sizeof(int), n, f) == (size_t) n;
+            ok = ok && fwrite(&death[0], sizeof(int), n, f) == (size_t) n;
+        }
+        if(na > 0)
+            ok = ok && fwrite(&activeSlots[0], sizeof(int), na, f) == (size_t) na;
+        return ok ? 0 : -1;
+    }
 
+    int VtxList::read(FILE *f){
+        int n = 0, na = 0;
+        if(fread(&n, sizeof(int), 1, f) != 1 || fread(&na, sizeof(int), 1, f) != 1 || n < 0 || na < 0 || na > n)
+            return -1;
+        if(fread(&maxUid, sizeof(unsigned int), 1, f) != 1)
+            return -1;
+        coords.resize(n); coordsD.resize(n); wind.resize(n); uid.resize(n);
+        active.resize(n); birth.resize(n); death.resize(n);
+        seen.assign(n, 0);
+        activeSlots.resize(na);
+        int ok = 1;
+        if(n > 0){
+            ok = ok && fread(&coords[0], sizeof(int2), n, f) == (size_t) n;
+            ok = ok && fread(&coordsD[0], sizeof(double2), n, f) == (size_t) n;
+            ok = ok && fread(&wind[0], sizeof(int), n, f) == (size_t) n;
+            ok = ok && fread(&uid[0], sizeof(unsigned int), n, f) == (size_t) n;
+            ok = ok && fread(&active[0], sizeof(char), n, f) == (size_t) n;
+            ok = ok && fread(&birth[0], sizeof(int), n, f) == (size_t) n;
+            ok = ok && fread(&death[0], sizeof(int), n, f) == (size_t) n;
+        }
+        if(na > 0)
+            ok = ok && fread(&activeSlots[0], sizeof(int), na, f) == (size_t) na;
+        slotOfUid.assign(n > 0 ? 2*(size_t)maxUid + 1 : 0, -1);
+        for(int s = 0; ok && s < n; ++s)
+            slotOfUid[uid[s]] = s;
+        updates = 0;
+        born = died = 0;
+        return ok ? 0 : -1;
     }
 }